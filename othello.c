@@ -1,56 +1,608 @@
+#define _POSIX_C_SOURCE 200809L
+
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 
-//Sets up the board based on dimensions given by user
-void setupBoard(char board[][26], int boardDimension) {
+//Directions a ray can travel from a position, in the order the search and flip functions are listed
+enum Direction {
+    NORTH,
+    NORTH_EAST,
+    EAST,
+    SOUTH_EAST,
+    SOUTH,
+    SOUTH_WEST,
+    WEST,
+    NORTH_WEST,
+    NUM_DIRECTIONS
+};
+
+//Columns on the edges of an 8x8 bitboard, where bit (row * 8 + col) represents board[row][col]
+const uint64_t COLUMN_A_8 = 0x0101010101010101ULL;
+const uint64_t COLUMN_H_8 = 0x8080808080808080ULL;
+
+/**Positions of an 8x8 bitboard in a line out from a square to the edge in each direction, built while compiling
+ * Directions that go up the bitboard are East, South East, South and South West, the rest go down it
+ */
+#define RAY_ROW_STEP_8(direction) \
+    ((direction) == NORTH || (direction) == NORTH_EAST || (direction) == NORTH_WEST ? -1 : \
+     (direction) == SOUTH_EAST || (direction) == SOUTH || (direction) == SOUTH_WEST ? 1 : 0)
+#define RAY_COL_STEP_8(direction) \
+    ((direction) == NORTH_EAST || (direction) == EAST || (direction) == SOUTH_EAST ? 1 : \
+     (direction) == SOUTH_WEST || (direction) == WEST || (direction) == NORTH_WEST ? -1 : 0)
+#define RAY_BIT_8(square, direction, step) \
+    ((unsigned) ((square) / 8 + (step) * RAY_ROW_STEP_8(direction)) < 8 && \
+     (unsigned) ((square) % 8 + (step) * RAY_COL_STEP_8(direction)) < 8 ? \
+     1ULL << (((square) + (step) * (8 * RAY_ROW_STEP_8(direction) + RAY_COL_STEP_8(direction))) & 63) : 0)
+#define RAY_8(square, direction) \
+    (RAY_BIT_8(square, direction, 1) | RAY_BIT_8(square, direction, 2) | RAY_BIT_8(square, direction, 3) | \
+     RAY_BIT_8(square, direction, 4) | RAY_BIT_8(square, direction, 5) | RAY_BIT_8(square, direction, 6) | \
+     RAY_BIT_8(square, direction, 7))
+#define RAYS_8(square) \
+    {RAY_8(square, NORTH), RAY_8(square, NORTH_EAST), RAY_8(square, EAST), RAY_8(square, SOUTH_EAST), \
+     RAY_8(square, SOUTH), RAY_8(square, SOUTH_WEST), RAY_8(square, WEST), RAY_8(square, NORTH_WEST)}
+#define RAYS_8_ROW(row) \
+    RAYS_8(8 * (row)), RAYS_8(8 * (row) + 1), RAYS_8(8 * (row) + 2), RAYS_8(8 * (row) + 3), \
+    RAYS_8(8 * (row) + 4), RAYS_8(8 * (row) + 5), RAYS_8(8 * (row) + 6), RAYS_8(8 * (row) + 7)
+
+const uint64_t RAYS_8[64][NUM_DIRECTIONS] = {
+    RAYS_8_ROW(0), RAYS_8_ROW(1), RAYS_8_ROW(2), RAYS_8_ROW(3), RAYS_8_ROW(4), RAYS_8_ROW(5), RAYS_8_ROW(6), RAYS_8_ROW(7)
+};
+
+//Largest board dimension the game supports
+#define MAX_DIMENSION 26
+
+//Number of 64-bit words needed to hold one bit per position on a board
+#define DIMENSION_WORDS(dimension) (((dimension) * (dimension) + 63) / 64)
+#define BOARD_WORDS DIMENSION_WORDS(MAX_DIMENSION)
+
+//Forces a function into its callers, so a constant dimension passed to it is folded into its loops and bounds
+#define ALWAYS_INLINE static inline __attribute__((always_inline))
+
+/**The board kernels have a copy for each even dimension, the ones Othello is played on, stamped out by a macro
+ * given a name for the copy and its dimension, with the copy for any other dimension reading it from the board
+ * Each copy's dimension is a constant, so its loops have fixed trip counts the compiler can unroll and vectorise
+ */
+#define FOR_EACH_EVEN_DIMENSION(define) \
+    define(4, 4) define(6, 6) define(8, 8) define(10, 10) define(12, 12) define(14, 14) define(16, 16) \
+    define(18, 18) define(20, 20) define(22, 22) define(24, 24) define(26, 26)
+
+//Table of a kernel's copies by dimension, odd dimensions use the copy for any dimension
+#define KERNEL_TABLE(name) { \
+    name##Any, name##Any, name##Any, name##Any, name##4, name##Any, name##6, name##Any, name##8, name##Any, \
+    name##10, name##Any, name##12, name##Any, name##14, name##Any, name##16, name##Any, name##18, name##Any, \
+    name##20, name##Any, name##22, name##Any, name##24, name##Any, name##26}
+
+//Set of positions on a board, bit (row * boardDimension + col) represents board[row][col]
+typedef struct {
+    uint64_t words[BOARD_WORDS];
+} BitSet;
+
+//Board of any dimension stored as one set of positions per colour
+typedef struct {
+    int dimension;
+    int numWords; //Number of words in each set that hold positions on this board
+    BitSet white;
+    BitSet black;
+} BitBoard;
+
+//Masks used to keep shifted positions from wrapping between rows or running off the board
+typedef struct {
+    BitSet onBoard;
+    BitSet notFirstColumn;
+    BitSet notLastColumn;
+} BitBoardMasks;
+
+/**Tests of whether each square of a dimension is in each mask, only valid for dimensions from 1 up
+ * The masks are built from these one bit at a time while compiling, so no time is spent on them when the program runs
+ */
+#define ON_BOARD_SQUARE(dimension, square) ((square) < (dimension) * (dimension))
+#define NOT_FIRST_COLUMN_SQUARE(dimension, square) (ON_BOARD_SQUARE(dimension, square) && (square) % (dimension) != 0)
+#define NOT_LAST_COLUMN_SQUARE(dimension, square) \
+    (ON_BOARD_SQUARE(dimension, square) && (square) % (dimension) != (dimension) - 1)
+
+//Bits of word of a mask, eight at a time, then the whole mask for a dimension
+#define MASK_BIT(test, dimension, word, bit) ((uint64_t) test(dimension, 64 * (word) + (bit)) << (bit))
+#define MASK_BYTE(test, dimension, word, bit) \
+    (MASK_BIT(test, dimension, word, bit) | MASK_BIT(test, dimension, word, bit + 1) | \
+     MASK_BIT(test, dimension, word, bit + 2) | MASK_BIT(test, dimension, word, bit + 3) | \
+     MASK_BIT(test, dimension, word, bit + 4) | MASK_BIT(test, dimension, word, bit + 5) | \
+     MASK_BIT(test, dimension, word, bit + 6) | MASK_BIT(test, dimension, word, bit + 7))
+#define MASK_WORD(test, dimension, word) \
+    (MASK_BYTE(test, dimension, word, 0) | MASK_BYTE(test, dimension, word, 8) | MASK_BYTE(test, dimension, word, 16) | \
+     MASK_BYTE(test, dimension, word, 24) | MASK_BYTE(test, dimension, word, 32) | MASK_BYTE(test, dimension, word, 40) | \
+     MASK_BYTE(test, dimension, word, 48) | MASK_BYTE(test, dimension, word, 56))
+#define MASK_SET(test, dimension) {{ \
+    MASK_WORD(test, dimension, 0), MASK_WORD(test, dimension, 1), MASK_WORD(test, dimension, 2), \
+    MASK_WORD(test, dimension, 3), MASK_WORD(test, dimension, 4), MASK_WORD(test, dimension, 5), \
+    MASK_WORD(test, dimension, 6), MASK_WORD(test, dimension, 7), MASK_WORD(test, dimension, 8), \
+    MASK_WORD(test, dimension, 9), MASK_WORD(test, dimension, 10)}}
+#define BIT_BOARD_MASKS(dimension) \
+    {MASK_SET(ON_BOARD_SQUARE, dimension), MASK_SET(NOT_FIRST_COLUMN_SQUARE, dimension), \
+     MASK_SET(NOT_LAST_COLUMN_SQUARE, dimension)}
+
+_Static_assert(BOARD_WORDS == 11, "MASK_SET writes out one mask word for each word of a BitSet");
+_Static_assert(MAX_DIMENSION == 26, "KERNEL_TABLE has an entry for each dimension");
+
+//Masks for each board dimension the game supports
+const BitBoardMasks bitBoardMasks[MAX_DIMENSION + 1] = {
+    [1] = BIT_BOARD_MASKS(1), [2] = BIT_BOARD_MASKS(2), [3] = BIT_BOARD_MASKS(3),
+    [4] = BIT_BOARD_MASKS(4), [5] = BIT_BOARD_MASKS(5), [6] = BIT_BOARD_MASKS(6), [7] = BIT_BOARD_MASKS(7),
+    [8] = BIT_BOARD_MASKS(8), [9] = BIT_BOARD_MASKS(9), [10] = BIT_BOARD_MASKS(10), [11] = BIT_BOARD_MASKS(11),
+    [12] = BIT_BOARD_MASKS(12), [13] = BIT_BOARD_MASKS(13), [14] = BIT_BOARD_MASKS(14), [15] = BIT_BOARD_MASKS(15),
+    [16] = BIT_BOARD_MASKS(16), [17] = BIT_BOARD_MASKS(17), [18] = BIT_BOARD_MASKS(18), [19] = BIT_BOARD_MASKS(19),
+    [20] = BIT_BOARD_MASKS(20), [21] = BIT_BOARD_MASKS(21), [22] = BIT_BOARD_MASKS(22), [23] = BIT_BOARD_MASKS(23),
+    [24] = BIT_BOARD_MASKS(24), [25] = BIT_BOARD_MASKS(25), [26] = BIT_BOARD_MASKS(26)
+};
+
+//Valid move along with how many tiles it flips in each direction
+typedef struct {
+    short row;
+    short col;
+    short totalFlips;
+    unsigned char numFlips[NUM_DIRECTIONS];
+} Move;
+
+//Every valid move for a colour, in the same order as the board
+typedef struct {
+    int numMoves;
+    Move moves[MAX_DIMENSION * MAX_DIMENSION];
+} MoveList;
+
+//Deepest search the computer can be asked to make
+#define MAX_SEARCH_DEPTH 60
+
+/**Most moves and passes that can be undone, enough for a whole game on the largest board followed by the deepest search
+ * A pass is always followed by a move or the end of the game, so there are never more passes than moves plus one
+ */
+#define MAX_UNDO (2 * MAX_DIMENSION * MAX_DIMENSION + 2 * MAX_SEARCH_DEPTH)
+
+//What is needed to take back a move or a pass
+typedef struct {
+    Move move; //Row is -1 for a pass
+    uint64_t hash; //Hash before the move
+} UndoRecord;
+
+/**State of a game owned by whoever is using it, so separate searches never share a board
+ * Moves are made and taken back in place, each one recorded on the state's own undo stack
+ */
+typedef struct {
+    BitBoard board;
+    char turn; //Colour to move
+    uint64_t hash; //Zobrist hash of the tiles and colour to move, kept up to date as moves are made
+    int numDiscs[2]; //Tiles of each colour, indexed like the Zobrist keys
+    int undoDepth;
+    UndoRecord undoStack[MAX_UNDO];
+} GameState;
+
+/**Symmetries of a square board: transposing it, then reversing the order of its columns, then of its rows
+ * Each combination of the three is one of the eight rotations and reflections, 0 leaves the board as it is
+ */
+enum Symmetry {
+    SYMMETRY_FLIP_COLUMNS = 1,
+    SYMMETRY_FLIP_ROWS = 2,
+    SYMMETRY_TRANSPOSE = 4,
+    NUM_SYMMETRIES = 8
+};
+
+//Positions with at most this many tiles are hashed by their canonical form in the hash table
+#define CANONICAL_HASH_DISCS 16
+
+/**Valid moves of both colours, kept up to date as a game is played instead of searching the whole board every turn
+ * Only unoccupied positions next to a tile (the frontier) can be valid, and after a move only the frontier
+ * positions on a row, column or diagonal through a changed tile need checking again
+ */
+typedef struct {
+    BitSet frontier;
+    BitSet valid[2]; //Valid positions of each colour, indexed like the Zobrist keys
+    int numValid[2];
+} MoveTracker;
+
+//Positions that can see each position along a ray, and positions next to it, for one board dimension
+typedef struct {
+    int dimension;
+    BitSet lines[MAX_DIMENSION * MAX_DIMENSION]; //Row, column and both diagonals through the position
+    BitSet neighbours[MAX_DIMENSION * MAX_DIMENSION];
+} TrackerMasks;
+
+//Most squares in one pattern, so a pattern's weights have at most 3^10 entries
+#define MAX_PATTERN_SQUARES 10
+
+//Most patterns and pattern shapes on one board
+#define MAX_PATTERNS 32
+#define MAX_PATTERN_TABLES 8
+
+//Part a square plays in a pattern, used to work out the weight of each arrangement of tiles
+enum SquareRole {
+    ROLE_INNER,
+    ROLE_EDGE,
+    ROLE_CORNER,
+    ROLE_C, //Next to a corner along an edge
+    ROLE_X //Diagonally next to a corner
+};
+
+//Squares covered by one pattern on the board, listed in the order of the digits of the pattern's base-3 index
+typedef struct {
+    int table; //Shape of the pattern, each shape has one table of weights shared by all its patterns
+    int numSquares;
+    short squares[MAX_PATTERN_SQUARES];
+} Pattern;
+
+//Shape of a pattern and where its weights start
+typedef struct {
+    int numSquares;
+    unsigned char roles[MAX_PATTERN_SQUARES];
+    signed char corners[MAX_PATTERN_SQUARES]; //Square in the pattern holding the corner next to an X or C square, -1 if none
+    int lineLength; //The first squares run along an edge, tiles there in an unbroken run from a corner cannot be flipped
+    int offset; //Start of the shape's weights in the evaluator's block of weights
+} PatternTable;
+
+/**Patterns used to evaluate positions on one board dimension
+ * Each pattern's tiles form a base-3 number (0 unoccupied, 1 the colour to move, 2 the other colour), which indexes
+ * the weight of that arrangement in its table, so a position costs one lookup per pattern
+ */
+typedef struct {
+    bool initialized;
+    int numPatterns;
+    int numTables;
+    Pattern patterns[MAX_PATTERNS];
+    PatternTable tables[MAX_PATTERN_TABLES];
+    int16_t *weights; //Weights of every table in one block
+} PatternEvaluator;
+
+//Kinds of score stored in the hash table
+enum HashBound {
+    BOUND_NONE,
+    BOUND_EXACT, //Score is exact
+    BOUND_LOWER, //Search failed high, score is at least this
+    BOUND_UPPER //Search failed low, score is at most this
+};
+
+//Result of searching a position, stored in the hash table
+typedef struct {
+    int score;
+    int bestSquare; //Best move as (row * boardDimension + col), -1 if none
+    int depth;
+    int bound;
+    int generation; //Search the entry was stored by
+} HashEntry;
+
+/**Hash table entry packed into two words so threads can share the table without locks
+ * The key is stored xored with the data, so an entry torn by two threads writing at once never matches a key
+ */
+typedef struct {
+    _Atomic uint64_t check; //Key xored with data
+    _Atomic uint64_t data; //Score, best move, depth, bound and generation packed together, zero if empty
+} HashSlot;
+
+/**Transposition table of searched positions, indexed by the low bits of the Zobrist hash
+ * An entry is replaced when it is empty, holds the same position, was stored by an earlier search,
+ * or was searched no deeper than the new result
+ * The usage counts are totals from every finished search, each search counts its own while it runs
+ */
+typedef struct {
+    HashSlot *slots;
+    uint64_t mask; //Number of entries minus one, the number of entries is a power of two
+    int generation;
+    long long probes;
+    long long hits; //Probes that found the position
+    long long collisions; //Probes that found a different position in the entry
+    long long stores;
+    long long overwrites; //Stores that replaced a different position
+} HashTable;
+
+//Random keys xored into the hash for each colour at each position, and for Black to move
+uint64_t zobristKeys[2][MAX_DIMENSION * MAX_DIMENSION];
+uint64_t zobristBlackToMove;
+
+//Score of a finished game before the disc difference is added, larger than any position score
+#define WIN_SCORE 1000000
+
+/**Counts of the work done on the hot paths, only kept in builds with OTHELLO_STATS defined
+ * Each thread counts into its own copy, which it adds to a shared total when it finishes
+ */
+typedef struct {
+    long long moveGenerations; //Searches of a whole board for valid moves
+    long long raysWalked; //Directions followed from a position to count its flips
+    long long boundsChecks;
+    long long flipsApplied; //Tiles turned over, on any board
+    long long nodes; //Positions visited by the search
+    long long endgameNodes; //Positions visited by the endgame solver
+    long long hashProbes;
+    long long hashHits;
+    long long playouts; //Monte Carlo playouts
+} Stats;
+
+//What is written with --stats
+enum StatsMode {
+    STATS_OFF,
+    STATS_GAME, //One line at the end of the game
+    STATS_MOVES //One line after each computer move as well
+};
+
+//How the board is shown after each move, set with --render
+enum RenderMode {
+    RENDER_FULL, //The whole board, written in one call
+    RENDER_DIFF, //The whole board once at the top of the terminal, then only the positions that changed
+    RENDER_SILENT //No board
+};
+
+//Longest board text, a header row and a row for each row of the board, each with a letter, a space and a newline
+#define BOARD_TEXT_SIZE ((MAX_DIMENSION + 3) * (MAX_DIMENSION + 1))
+
+//Longest change to the board shown, every position with the escape sequence moving the cursor to it
+#define RENDER_BUFFER_SIZE (BOARD_TEXT_SIZE + 16 * MAX_DIMENSION * MAX_DIMENSION + 64)
+
+//The board as last shown in the terminal, so a diff only has to redraw the positions that have changed
+typedef struct {
+    int mode;
+    bool drawn; //Whether the whole board has been drawn yet
+    char shown[26][26];
+    char text[RENDER_BUFFER_SIZE];
+} BoardRenderer;
+
+#ifdef OTHELLO_STATS
+_Thread_local Stats threadStats;
+#define COUNT_STAT(counter, amount) (threadStats.counter += (amount))
+#else
+#define COUNT_STAT(counter, amount) ((void) 0)
+#endif
+
+//Settings for how the computer chooses its moves
+typedef struct {
+    int searchDepth; //Deepest iteration of the search, 0 keeps the greedy flip count
+    long long searchNodes; //Positions the search may visit per move, 0 for no limit
+    int hashMegabytes; //Size of the hash table, 0 for no hash table
+    int threads; //Threads searching each position, sharing the hash table
+    bool verbose; //Report each search and the hash table usage on stderr
+    int endgameEmpties; //Solve the game exactly once this few positions are unoccupied, 0 to never solve
+    bool endgameWinLossDraw; //Only solve for a win, loss or draw, not the best disc difference
+    const char *bookFileName; //Opening book played from before searching, NULL for none
+    long long mctsPlayouts; //Playouts of the Monte Carlo tree search per move, 0 for no limit
+    int mctsMilliseconds; //Time the Monte Carlo tree search may take per move, 0 for no limit
+    double mctsExploration; //Weight of the exploration term when a node's child is selected
+    int treeMegabytes; //Size of the arena the Monte Carlo search tree is built in
+    int moveMilliseconds; //Time the computer may take for each move, 0 for no limit
+    double clockSeconds; //Time the computer has for the whole game, shared out over its moves, 0 for no clock
+    double incrementSeconds; //Time added to the computer's clock after each of its moves
+    bool ponder; //Search the human's position while waiting for the human's move, keeping the results in the hash table
+    int statsMode; //Statistics written as JSON lines on stderr
+    int renderMode; //How the board is shown, not really a computer setting but read with the others
+} ComputerSettings;
+
+/**Time kept back from each move's budget for choosing and making the move around the search, in seconds,
+ * and the share of the rest kept back for the search's threads being scheduled late
+ */
+#define MOVE_TIME_MARGIN 0.002
+#define MOVE_TIME_SAFETY 0.1
+
+//Most of the time left on the clock a single move may use
+#define MAX_CLOCK_SHARE 0.25
+
+//Share of a move's budget the endgame solver may use before giving up, leaving the rest for the search
+#define ENDGAME_TIME_SHARE 0.5
+
+//Share of a move's budget after which the search does not start another iteration, as it would likely not finish
+#define ITERATION_TIME_SHARE 0.5
+
+//Nodes the endgame solver visits between looks at its stop flag
+#define ENDGAME_STOP_INTERVAL 1024
+
+//Most plies below the position being searched, a pass does not use up depth but is always followed by a move or the end
+#define MAX_PLY (2 * MAX_SEARCH_DEPTH + 2)
+
+//Remaining depth from which moves are ordered by the opponent's replies
+#define MOBILITY_ORDER_DEPTH 4
+
+//History score of a move above which a colour's history is halved
+#define MAX_HISTORY (1 << 20)
+
+//Limits and progress of one search, each thread searching a position has its own
+typedef struct {
+    int maxDepth;
+    long long maxNodes;
+    long long nodes;
+    atomic_bool *stop; //Set when every thread searching the position should stop
+    HashTable *table; //Hash table shared by every thread searching the position
+    bool aborted;
+    int completedDepth;
+    int bestScore;
+    int threadIndex; //0 for the main thread, helper threads vary their move order by their index
+    long long hashProbes;
+    long long hashHits;
+    long long hashCollisions;
+    long long hashStores;
+    long long hashOverwrites;
+    double deadline; //Time every thread is stopped, from getSeconds, 0 for no limit
+    double iterationDeadline; //Time after which no new iteration is started, 0 for no limit
+    int rootUndoDepth; //Undo depth of the position being searched, the ply of a position is its undo depth beyond this
+    int killers[MAX_PLY][2]; //Last two moves to cause a cutoff at each ply, as (row * boardDimension + col), -1 if none
+    int history[2][MAX_DIMENSION * MAX_DIMENSION]; //Cutoffs caused by each move of each colour, weighted by depth
+    long long cutoffs;
+    long long firstMoveCutoffs; //Cutoffs caused by the first move searched
+    long long cutoffIndexSum; //Positions in the order of the moves that caused cutoffs, summed
+} SearchInfo;
+
+//Bound beyond any final disc difference, used as the starting score of the endgame solver
+#define ENDGAME_SCORE_LIMIT (MAX_DIMENSION * MAX_DIMENSION + 1)
+
+//Unoccupied positions above which the endgame solver orders moves by the opponent's replies, not just by parity
+#define FASTEST_FIRST_EMPTIES 7
+
+//Progress and result of solving an endgame exactly
+typedef struct {
+    bool winLossDraw; //Only find whether the colour to move wins, loses or draws, which is cheaper
+    long long nodes;
+    atomic_bool *stop; //Set when the solver should give up, NULL if it always finishes
+    bool aborted;
+    int stopCountdown; //Nodes until the stop flag is looked at again
+    int score; //Final disc difference for the colour to move with perfect play, or its sign
+} EndgameInfo;
+
+//Exploration weight of the Monte Carlo tree search unless another is given
+#define MCTS_EXPLORATION 1.4
+
+//States of a Monte Carlo search tree node, only an expanded node's children can be read
+enum MctsNodeState {
+    MCTS_UNEXPANDED,
+    MCTS_EXPANDING, //Claimed by one thread, others treat it as a leaf until it is expanded
+    MCTS_EXPANDED
+};
+
+//Node of a Monte Carlo search tree, every node of the tree for a move comes from the same arena
+typedef struct {
+    short square; //Move into this node, as (row * boardDimension + col), -1 for a pass
+    atomic_int state;
+    int firstChild; //Arena index of the first child, the children are next to each other
+    int numChildren; //0 once expanded if the game is over
+    atomic_int visits;
+    atomic_int virtualLosses; //Playouts through this node that have not finished yet, counted as losses
+    atomic_int score; //Two for each win and one for each draw of the colour that moved into this node
+} MctsNode;
+
+//Bump allocator the Monte Carlo search tree is built in, reset before each move instead of freeing nodes
+typedef struct {
+    MctsNode *nodes;
+    int capacity;
+    atomic_int used;
+    int peak; //Most nodes the tree for any one move has used
+} MctsArena;
+
+//Limits and progress of a Monte Carlo tree search, shared by every thread searching the position
+typedef struct {
+    MctsArena *arena;
+    BitBoard root;
+    char turn; //Colour to move at the root
+    double exploration;
+    long long maxPlayouts; //0 for no limit
+    double deadline; //Time the search stops, from getSeconds, 0 for no limit
+    uint64_t seed; //Each thread's random playouts are seeded from this and its index
+    atomic_llong playouts; //Playouts started, including ones turned away by the playout limit
+    long long completed;
+    int bestVisits;
+    int bestScore;
+} MctsSearch;
+
+ComputerSettings computerSettings = {0, 0, 16, 1, false, 0, false, NULL, 0, 0, MCTS_EXPLORATION, 64, 0, 0, 0, false, STATS_OFF,
+                                      RENDER_FULL};
+
+//Time left on the computer's clock when it plays with a time control
+double computerClock;
+
+TrackerMasks trackerMasks;
+
+//Patterns for each board dimension, built the first time a dimension is evaluated
+PatternEvaluator patternEvaluators[MAX_DIMENSION + 1];
+
+HashTable hashTable;
+
+MctsArena mctsArena;
+
+//Change in row and column for one step in each direction
+const int DELTA_ROW[NUM_DIRECTIONS] = {-1, -1, 0, 1, 1, 1, 0, -1};
+const int DELTA_COL[NUM_DIRECTIONS] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+/**Writes the game board as text, a header row of column letters then each row with its letter
+ * Returns the length of the text, which is not terminated
+ */
+int formatBoard(char board[][26], int boardDimension, char *text) {
+    int length = 0;
     
-    //Initialize all spots on the board as unoccupied
-    for (int row = 0; row < boardDimension; row++) {
-        for (int col = 0; col < boardDimension; col++) {
-            board[row][col] = 'U';
-        }
+    //Write out the first row
+    text[length++] = ' ';
+    text[length++] = ' ';
+    for (int col = 0; col < boardDimension; col++) {
+        text[length++] = 'a' + col;
     }
+    text[length++] = '\n';
     
-    //Initialize the four coloured spots
-    int index = boardDimension / 2 - 1; //Index of top-left of centre of board
-    board[index][index] = 'W'; //Top-left of centre four spots is White
-    board[index][index + 1] = 'B'; //Top-right of centre four spots is Black
-    board[index + 1][index] = 'B'; //Bottom-left of centre four spots is Black
-    board[index + 1][index + 1] = 'W'; //Bottom-right of centre four spots is White
+    //Write out the game board, each row after its header
+    for (int row = 0; row < boardDimension; row++) {
+        text[length++] = 'a' + row;
+        text[length++] = ' ';
+        memcpy(&text[length], board[row], boardDimension);
+        length += boardDimension;
+        text[length++] = '\n';
+    }
+    return length;
 }
 
-//Prints the game board
+//Prints the game board, formatting it all first so it is written in one call
 void printBoard(char board[][26], int boardDimension) {
-    
-    //Print out the first row
-    printf("  ");
-    char c = 'a';
-    for (int i = 0; i < boardDimension; i++) {
-        printf("%c", c);
-        c++;
+    char text[BOARD_TEXT_SIZE];
+    int length = formatBoard(board, boardDimension, text);
+    fwrite(text, 1, length, stdout);
+}
+
+/**Shows the board in the renderer's mode
+ * A diff clears the terminal and draws the whole board at the top the first time, then keeps everything else
+ * scrolling below it, so later moves only redraw the positions that changed, the placed tile and the flipped ones
+ * Positions are drawn with the cursor moved to them, then the cursor goes back to where the scrolling text left it
+ */
+void renderBoard(BoardRenderer *renderer, char board[][26], int boardDimension) {
+    if (renderer->mode == RENDER_SILENT) {
+        return;
+    }
+    if (renderer->mode == RENDER_FULL) {
+        printBoard(board, boardDimension);
+        return;
     }
-    printf("\n");
     
-    //Print out the game board
-    c = 'a';
-    for (int row = 0; row < boardDimension; row++) {
-        for (int col = 0; col < boardDimension; col++) {
-            
-            //Print the row header
-            if (col == 0) {
-                printf("%c ", c);
-                c++;
+    int length = 0;
+    if (!renderer->drawn) {
+        
+        //Clear the terminal, draw the board at the top, and make only the lines below the board scroll
+        length += sprintf(&renderer->text[length], "\033[2J\033[H");
+        length += formatBoard(board, boardDimension, &renderer->text[length]);
+        length += sprintf(&renderer->text[length], "\033[%d;r\033[%d;1H", boardDimension + 2, boardDimension + 2);
+        renderer->drawn = true;
+    }
+    else {
+        
+        //Save the cursor, then move to each changed position, a position right after the last one needs no move
+        length += sprintf(&renderer->text[length], "\0337");
+        int lastRow = -1, lastCol = -1;
+        for (int row = 0; row < boardDimension; row++) {
+            for (int col = 0; col < boardDimension; col++) {
+                if (board[row][col] == renderer->shown[row][col]) {
+                    continue;
+                }
+                if (row != lastRow || col != lastCol + 1) {
+                    length += sprintf(&renderer->text[length], "\033[%d;%dH", row + 2, col + 3);
+                }
+                renderer->text[length++] = board[row][col];
+                lastRow = row;
+                lastCol = col;
             }
-            
-            //Print out letter at the index
-            printf("%c", board[row][col]);
         }
-        printf("\n");
+        length += sprintf(&renderer->text[length], "\0338");
+    }
+    
+    memcpy(renderer->shown, board, sizeof(renderer->shown));
+    fwrite(renderer->text, 1, length, stdout);
+}
+
+//Lets the whole terminal scroll again once the game is over, if a diff fixed the board at the top
+void finishRendering(BoardRenderer *renderer) {
+    if (renderer->mode == RENDER_DIFF && renderer->drawn) {
+        printf("\0337\033[r\0338");
     }
 }
 
 //Checks to see if entered position is within bounds of board
 bool positionInBounds(int boardDimension, int row, int col) {
+    COUNT_STAT(boundsChecks, 1);
     
     //Ensure indices are not negative
     if (row < 0 || col < 0) {
@@ -63,261 +615,131 @@ bool positionInBounds(int boardDimension, int row, int col) {
     return false;
 }
 
-/**Checks if row and col is a legal position for a tile
- * "Looks" in direction specified, receives how many positions in each direction to look
- * A move has a chance to be legal if the spot being looked at is the opposite colour
+//Distance between positions one row apart on a board, which always has 26 columns whatever its dimension
+#define BOARD_ROW_STRIDE 26
+
+//Step through a board for one position in each direction
+const int RAY_STEP[NUM_DIRECTIONS] = {
+    -BOARD_ROW_STRIDE, -BOARD_ROW_STRIDE + 1, 1, BOARD_ROW_STRIDE + 1, BOARD_ROW_STRIDE, BOARD_ROW_STRIDE - 1, -1,
+    -BOARD_ROW_STRIDE - 1
+};
+
+/**Number of positions between each position and the edge of the board in each direction, for one dimension
+ * Walks on the board and on the bit board both stop at these, so no step of a walk is checked against the bounds
  */
-bool checkLegalInDirection(char board[][26], int boardDimension, int row, int col, char colour, int deltaRow, int deltaCol) {
-    
-    //Determine the position function should check
-    int testRow = row + deltaRow;
-    int testCol = col + deltaCol;
-    
-    //Ensure position is in bounds, if out of bounds return false
-    if (!positionInBounds(boardDimension, testRow, testCol)) {
-        return false;
-    }
-    
-    //Determine the opposite colour
-    char oppositeColour = '0';
-    if (colour == 'W') {
-        oppositeColour = 'B';
-    }
-    else {
-        oppositeColour = 'W';
-    }
-    
-    //Check position to see if it is occupied by the opposite colour
-    //If so, this direction has a chance to be a legal move (it is legal so far)
-    if (board[testRow][testCol] == oppositeColour) {
-        return true;
-    }
-    //If position is unoccupied or the same colour, move is no longer legal
-    else {
-        return false;
+typedef unsigned char RayLengths[MAX_DIMENSION][MAX_DIMENSION][NUM_DIRECTIONS];
+
+/**Ray lengths for each dimension, built the first time a board of that dimension is searched, on whichever thread
+ * gets there first, so only the dimensions in use take up memory
+ * The flag lets every later search skip the lock
+ */
+RayLengths rayLengths[MAX_DIMENSION + 1];
+atomic_bool rayLengthsBuilt[MAX_DIMENSION + 1];
+pthread_mutex_t rayLengthsLock = PTHREAD_MUTEX_INITIALIZER;
+
+void buildRayLengths(int boardDimension) {
+    for (int row = 0; row < boardDimension; row++) {
+        for (int col = 0; col < boardDimension; col++) {
+            for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+                
+                //Step out until the next step would leave the board
+                int length = 0;
+                int testRow = row + DELTA_ROW[direction];
+                int testCol = col + DELTA_COL[direction];
+                while (testRow >= 0 && testRow < boardDimension && testCol >= 0 && testCol < boardDimension) {
+                    length++;
+                    testRow += DELTA_ROW[direction];
+                    testCol += DELTA_COL[direction];
+                }
+                rayLengths[boardDimension][row][col][direction] = length;
+            }
+        }
     }
 }
 
-/**Checks to see if the final position of a travelled direction qualifies position as a valid move
- * Compares colour at this position to player's colour
- */
-bool checkFinalPosition (int row, int col, char colour, int boardDimension, char board[][26]) {
-    if (positionInBounds(boardDimension, row, col) && board[row][col] == colour) {
-        return true;
+//Gets the ray lengths for a board dimension, building them if no search has needed them yet
+static inline const RayLengths *getRayLengths(int boardDimension) {
+    if (!atomic_load_explicit(&rayLengthsBuilt[boardDimension], memory_order_acquire)) {
+        pthread_mutex_lock(&rayLengthsLock);
+        if (!atomic_load_explicit(&rayLengthsBuilt[boardDimension], memory_order_relaxed)) {
+            buildRayLengths(boardDimension);
+            atomic_store_explicit(&rayLengthsBuilt[boardDimension], true, memory_order_release);
+        }
+        pthread_mutex_unlock(&rayLengthsLock);
     }
-    return false;
+    return &rayLengths[boardDimension];
 }
 
-//Searches in the North Direction, returns how many tiles can be flipped, zero if no move can be made
-int searchNorth(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in North position
-    int deltaNorth = -1;
+/**Walks a ray out from a position, returns how many tiles can be flipped, zero if no move can be made
+ * The ray's length stops the walk at the edge of the board, so no step has to be checked against the bounds
+ */
+ALWAYS_INLINE int walkRay(const char *start, int length, int step, char colour, char opponent) {
+    COUNT_STAT(raysWalked, 1);
     
-    //Track how many tiles can be flipped
+    //Count the opposite colour tiles next to the position, only stepping while the ray has positions left
     int tilesFlipped = 0;
-    
-    //Check in North direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot North, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaNorth, 0)) {
-        deltaNorth--;
+    const char *square = start;
+    while (tilesFlipped < length && *(square += step) == opponent) {
         tilesFlipped++;
     }
     
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaNorth, col, colour, boardDimension, board)) {
+    //They are only flipped if the ray carries on to one of the colour's tiles, the position the walk stopped at
+    if (tilesFlipped > 0 && tilesFlipped < length && *square == colour) {
         return tilesFlipped;
     }
-    else {
-        return 0;
-    }
+    return 0;
+}
+
+//Walks the ray from a position in the direction given, each direction's search has a copy with its step a constant
+ALWAYS_INLINE int searchRay(char board[][26], int boardDimension, int row, int col, char colour, int direction) {
+    const char *start = (const char *) board + row * BOARD_ROW_STRIDE + col;
+    int length = (*getRayLengths(boardDimension))[row][col][direction];
+    return walkRay(start, length, RAY_STEP[direction], colour, colour == 'W' ? 'B' : 'W');
+}
+
+//Searches in the North Direction, returns how many tiles can be flipped, zero if no move can be made
+int searchNorth(int row, int col, char colour, char board[][26], int boardDimension) {
+    return searchRay(board, boardDimension, row, col, colour, NORTH);
 }
 
 //Searches in the North East Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchNorthEast(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in North East position
-    int deltaNorth = -1;
-    int deltaEast = 1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in North East direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot North East, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaNorth, deltaEast)) {
-        deltaNorth--;
-        deltaEast++;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaNorth, col + deltaEast, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, NORTH_EAST);
 }
 
 //Searches in the East Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchEast(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in East position
-    int deltaEast = 1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in East direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot East, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, 0, deltaEast)) {
-        deltaEast++;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row, col + deltaEast, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, EAST);
 }
 
 //Searches in the South East Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchSouthEast(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in South East position
-    int deltaSouth = 1;
-    int deltaEast = 1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in South East direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot South East, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaSouth, deltaEast)) {
-        deltaSouth++;
-        deltaEast++;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaSouth, col + deltaEast, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, SOUTH_EAST);
 }
 
 //Searches in the South Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchSouth(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in South position
-    int deltaSouth = 1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in South direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot South, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaSouth, 0)) {
-        deltaSouth++;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaSouth, col, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, SOUTH);
 }
 
 //Searches in the South West Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchSouthWest(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in South West position
-    int deltaSouth = 1;
-    int deltaWest = -1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in South West direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot South West, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaSouth, deltaWest)) {
-        deltaSouth++;
-        deltaWest--;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaSouth, col + deltaWest, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, SOUTH_WEST);
 }
 
 //Searches in the West Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchWest(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in West position
-    int deltaWest = -1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in West direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot West, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, 0, deltaWest)) {
-        deltaWest--;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row, col + deltaWest, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, WEST);
 }
 
 //Searches in the North West Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchNorthWest(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in North West position
-    int deltaNorth = -1;
-    int deltaWest = -1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in North West direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot North West, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaNorth, deltaWest)) {
-        deltaNorth--;
-        deltaWest--;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaNorth, col + deltaWest, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, NORTH_WEST);
 }
 
 //Flips tiles in the North direction
 void flipNorth(char board[][26], int row, int col, int numFlips, char colour) {
+    COUNT_STAT(flipsApplied, numFlips);
     
     //Flip tiles in North direction
     for (int i = 1; i <= numFlips; i++) {
@@ -327,6 +749,7 @@ void flipNorth(char board[][26], int row, int col, int numFlips, char colour) {
 
 //Flips tiles in the North East direction
 void flipNorthEast(char board[][26], int row, int col, int numFlips, char colour) {
+    COUNT_STAT(flipsApplied, numFlips);
    
     //Flip tiles in North East direction
     for (int i = 1; i <= numFlips; i++) {
@@ -336,6 +759,7 @@ void flipNorthEast(char board[][26], int row, int col, int numFlips, char colour
 
 //Flips tiles in the East direction
 void flipEast(char board[][26], int row, int col, int numFlips, char colour) {
+    COUNT_STAT(flipsApplied, numFlips);
     
     //Flip tiles in East direction
     for (int i = 1; i <= numFlips; i++) {
@@ -346,6 +770,7 @@ void flipEast(char board[][26], int row, int col, int numFlips, char colour) {
 
 //Flips tiles in the South East direction
 void flipSouthEast(char board[][26], int row, int col, int numFlips, char colour) {
+    COUNT_STAT(flipsApplied, numFlips);
 
     //Flip tiles in South East direction
     for (int i = 1; i <= numFlips; i++) {
@@ -355,6 +780,7 @@ void flipSouthEast(char board[][26], int row, int col, int numFlips, char colour
 
 //Flips tiles in the South direction
 void flipSouth(char board[][26], int row, int col, int numFlips, char colour) {
+    COUNT_STAT(flipsApplied, numFlips);
 
     //Flip tiles in South direction
     for (int i = 1; i <= numFlips; i++) {
@@ -364,6 +790,7 @@ void flipSouth(char board[][26], int row, int col, int numFlips, char colour) {
 
 //Flips tiles in the South West direction
 void flipSouthWest(char board[][26], int row, int col, int numFlips, char colour) {
+    COUNT_STAT(flipsApplied, numFlips);
 
     //Flip tiles in South West direction
     for (int i = 1; i <= numFlips; i++) {
@@ -373,6 +800,7 @@ void flipSouthWest(char board[][26], int row, int col, int numFlips, char colour
 
 //Flips tiles in the West direction
 void flipWest(char board[][26], int row, int col, int numFlips, char colour) {
+    COUNT_STAT(flipsApplied, numFlips);
 
     //Flip tiles in West direction
     for (int i = 1; i <= numFlips; i++) {
@@ -382,6 +810,7 @@ void flipWest(char board[][26], int row, int col, int numFlips, char colour) {
 
 //Flips tiles in the North West direction
 void flipNorthWest(char board[][26], int row, int col, int numFlips, char colour) {
+    COUNT_STAT(flipsApplied, numFlips);
 
     //Flip tiles in North West direction
     for (int i = 1; i <= numFlips; i++) {
@@ -389,275 +818,4181 @@ void flipNorthWest(char board[][26], int row, int col, int numFlips, char colour
     }
 }
 
-//Attempts to make move specified by user
-bool makeMove(char board[][26], int boardDimension, char player) {
-    
-    //Get move from player
-    char rowChar = '0', colChar = '0';
-    printf("Enter move for colour %c (RowCol): ", player);
-    scanf(" %c%c", &rowChar, &colChar);
-    
-    //Convert row and column into integer indices
-    int row = rowChar - 'a';
-    int col = colChar - 'a';
-    
-    //Ensure space is unoccupied
-    if (board[row][col] != 'U') {
-        return false;
+//Counts how many bits are set in a bitboard
+int countBits(uint64_t bits) {
+    return __builtin_popcountll(bits);
+}
+
+//Loads an 8x8 board into two bitboards, one holding the colour's tiles and one holding the opposite colour's tiles
+void loadBitboard8(char board[][26], char colour, uint64_t *own, uint64_t *opponent) {
+    
+    //Determine the opposite colour
+    char oppositeColour = colour == 'W' ? 'B' : 'W';
+    
+    *own = 0;
+    *opponent = 0;
+    for (int row = 0; row < 8; row++) {
+        for (int col = 0; col < 8; col++) {
+            uint64_t bit = 1ULL << (row * 8 + col);
+            if (board[row][col] == colour) {
+                *own |= bit;
+            }
+            else if (board[row][col] == oppositeColour) {
+                *opponent |= bit;
+            }
+        }
+    }
+}
+
+/**Moves every tile on an 8x8 bitboard one position in the direction given
+ * Tiles that would wrap around to the other side of the board are dropped
+ */
+uint64_t shiftBitboard8(uint64_t bits, int direction) {
+    switch (direction) {
+        case NORTH:
+            return bits >> 8;
+        case NORTH_EAST:
+            return (bits >> 7) & ~COLUMN_A_8;
+        case EAST:
+            return (bits << 1) & ~COLUMN_A_8;
+        case SOUTH_EAST:
+            return (bits << 9) & ~COLUMN_A_8;
+        case SOUTH:
+            return bits << 8;
+        case SOUTH_WEST:
+            return (bits << 7) & ~COLUMN_H_8;
+        case WEST:
+            return (bits >> 1) & ~COLUMN_H_8;
+        default:
+            return (bits >> 9) & ~COLUMN_H_8;
+    }
+}
+
+/**Finds every valid position on an 8x8 bitboard in one pass
+ * In each direction, runs of opposite colour tiles touching the colour's tiles are grown one position at a time,
+ * any unoccupied position just past a run is a valid move
+ */
+uint64_t findMovesBitboard8(uint64_t own, uint64_t opponent) {
+    COUNT_STAT(moveGenerations, 1);
+    uint64_t empty = ~(own | opponent);
+    uint64_t moves = 0;
+    
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        
+        //A run of opposite colour tiles is at most six long on an 8x8 board
+        uint64_t run = shiftBitboard8(own, direction) & opponent;
+        for (int i = 0; i < 5; i++) {
+            run |= shiftBitboard8(run, direction) & opponent;
+        }
+        moves |= shiftBitboard8(run, direction) & empty;
+    }
+    return moves;
+}
+
+/**Body of findFlipsBitboard8, which also counts the tiles flipped in each direction when numFlips is not NULL
+ * Callers pass NULL as a constant, so the counting is left out of their copy
+ * In each direction the nearest position on the ray not holding an opposite colour tile ends the run, and the run is
+ * flipped if that position holds one of the colour's tiles
+ */
+ALWAYS_INLINE uint64_t findFlipsOfBitboard8(uint64_t own, uint64_t opponent, int square, unsigned char *numFlips) {
+    COUNT_STAT(raysWalked, NUM_DIRECTIONS);
+    uint64_t flips = 0;
+    
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        uint64_t ray = RAYS_8[square][direction];
+        uint64_t ends = ray & ~opponent;
+        uint64_t line = 0;
+        if (ends != 0) {
+            
+            //Going up the bitboard the nearest end is the lowest bit, going down it is the highest
+            bool up = direction >= EAST && direction <= SOUTH_WEST;
+            uint64_t end = up ? ends & -ends : 1ULL << (63 - __builtin_clzll(ends));
+            if (end & own) {
+                line = ray & (up ? end - 1 : ~(2 * end - 1));
+            }
+        }
+        flips |= line;
+        if (numFlips != NULL) {
+            numFlips[direction] = countBits(line);
+        }
+    }
+    return flips;
+}
+
+//Finds the tiles flipped by placing a tile at square (row * 8 + col) of an 8x8 bitboard, zero if no move can be made
+uint64_t findFlipsBitboard8(uint64_t own, uint64_t opponent, int square) {
+    return findFlipsOfBitboard8(own, opponent, square, NULL);
+}
+
+//Sets a position in a set of positions
+void addToBitSet(BitSet *bits, int square) {
+    bits->words[square / 64] |= 1ULL << (square % 64);
+}
+
+//Checks to see if a position is in a set of positions
+bool bitSetContains(const BitSet *bits, int square) {
+    return (bits->words[square / 64] >> (square % 64)) & 1;
+}
+
+//Checks to see if a set of positions is empty
+bool isBitSetEmpty(const BitSet *bits, int numWords) {
+    uint64_t any = 0;
+    for (int i = 0; i < numWords; i++) {
+        any |= bits->words[i];
+    }
+    return any == 0;
+}
+
+//Counts how many positions are in a set of positions
+int countBitSet(const BitSet *bits, int numWords) {
+    int count = 0;
+    for (int i = 0; i < numWords; i++) {
+        count += countBits(bits->words[i]);
+    }
+    return count;
+}
+
+//Gets the masks for a board dimension
+static inline const BitBoardMasks *getBitBoardMasks(int boardDimension) {
+    return &bitBoardMasks[boardDimension];
+}
+
+/**Moves every position in a set one step in the direction given
+ * Each row follows directly after the one before it, so a step is a shift of the words by a fixed amount
+ * Positions that wrap around to the other side of the board or run off the board are dropped
+ */
+ALWAYS_INLINE void shiftBitSet(const BitSet *bits, BitSet *shifted, int boardDimension, int numWords, int direction) {
+    const BitBoardMasks *masks = getBitBoardMasks(boardDimension);
+    int offset = DELTA_ROW[direction] * boardDimension + DELTA_COL[direction];
+    
+    //Moving towards higher positions, carry bits up from the word below
+    if (offset > 0) {
+        for (int i = numWords - 1; i > 0; i--) {
+            shifted->words[i] = (bits->words[i] << offset) | (bits->words[i - 1] >> (64 - offset));
+        }
+        shifted->words[0] = bits->words[0] << offset;
+    }
+    
+    //Moving towards lower positions, carry bits down from the word above
+    else {
+        offset = -offset;
+        for (int i = 0; i < numWords - 1; i++) {
+            shifted->words[i] = (bits->words[i] >> offset) | (bits->words[i + 1] << (64 - offset));
+        }
+        shifted->words[numWords - 1] = bits->words[numWords - 1] >> offset;
+    }
+    
+    //Choose the mask that drops positions that wrapped between rows
+    const BitSet *mask = &masks->onBoard;
+    if (DELTA_COL[direction] == 1) {
+        mask = &masks->notFirstColumn;
+    }
+    else if (DELTA_COL[direction] == -1) {
+        mask = &masks->notLastColumn;
+    }
+    for (int i = 0; i < numWords; i++) {
+        shifted->words[i] &= mask->words[i];
+    }
+}
+
+//Gets the set of positions held by a colour
+BitSet *getColourBitSet(BitBoard *bitBoard, char colour) {
+    return colour == 'W' ? &bitBoard->white : &bitBoard->black;
+}
+
+//Gets the set of positions held by the opposite of a colour
+BitSet *getOppositeBitSet(BitBoard *bitBoard, char colour) {
+    return colour == 'W' ? &bitBoard->black : &bitBoard->white;
+}
+
+//Sets up a bit board based on dimensions given by user
+void setupBitBoard(BitBoard *bitBoard, int boardDimension) {
+    
+    //Initialize all positions as unoccupied
+    bitBoard->dimension = boardDimension;
+    bitBoard->numWords = (boardDimension * boardDimension + 63) / 64;
+    for (int i = 0; i < BOARD_WORDS; i++) {
+        bitBoard->white.words[i] = 0;
+        bitBoard->black.words[i] = 0;
+    }
+    
+    //Initialize the four coloured positions in the centre of the board
+    int index = boardDimension / 2 - 1;
+    addToBitSet(&bitBoard->white, index * boardDimension + index);
+    addToBitSet(&bitBoard->black, index * boardDimension + index + 1);
+    addToBitSet(&bitBoard->black, (index + 1) * boardDimension + index);
+    addToBitSet(&bitBoard->white, (index + 1) * boardDimension + index + 1);
+}
+
+//Loads a board into a bit board
+void loadBitBoard(char board[][26], int boardDimension, BitBoard *bitBoard) {
+    bitBoard->dimension = boardDimension;
+    bitBoard->numWords = (boardDimension * boardDimension + 63) / 64;
+    for (int i = 0; i < BOARD_WORDS; i++) {
+        bitBoard->white.words[i] = 0;
+        bitBoard->black.words[i] = 0;
+    }
+    
+    for (int row = 0; row < boardDimension; row++) {
+        for (int col = 0; col < boardDimension; col++) {
+            if (board[row][col] == 'W') {
+                addToBitSet(&bitBoard->white, row * boardDimension + col);
+            }
+            else if (board[row][col] == 'B') {
+                addToBitSet(&bitBoard->black, row * boardDimension + col);
+            }
+        }
+    }
+}
+
+//Stores a bit board back into a board
+void storeBitBoard(const BitBoard *bitBoard, char board[][26]) {
+    int boardDimension = bitBoard->dimension;
+    for (int row = 0; row < boardDimension; row++) {
+        for (int col = 0; col < boardDimension; col++) {
+            int square = row * boardDimension + col;
+            if (bitSetContains(&bitBoard->white, square)) {
+                board[row][col] = 'W';
+            }
+            else if (bitSetContains(&bitBoard->black, square)) {
+                board[row][col] = 'B';
+            }
+            else {
+                board[row][col] = 'U';
+            }
+        }
+    }
+}
+
+//Sets up the board based on dimensions given by user, through a bit board
+void setupBoard(char board[][26], int boardDimension) {
+    BitBoard bitBoard;
+    setupBitBoard(&bitBoard, boardDimension);
+    storeBitBoard(&bitBoard, board);
+}
+
+//Finds the set of unoccupied positions on a bit board
+void findEmptyBitSet(const BitBoard *bitBoard, BitSet *empty) {
+    const BitBoardMasks *masks = getBitBoardMasks(bitBoard->dimension);
+    for (int i = 0; i < bitBoard->numWords; i++) {
+        empty->words[i] = masks->onBoard.words[i] & ~(bitBoard->white.words[i] | bitBoard->black.words[i]);
+    }
+}
+
+//Body of findBitBoardMoves, for a board of the dimension given
+ALWAYS_INLINE void findMovesOfDimension(BitBoard *bitBoard, char colour, BitSet *moves, int boardDimension) {
+    COUNT_STAT(moveGenerations, 1);
+    int numWords = DIMENSION_WORDS(boardDimension);
+    const BitBoardMasks *masks = getBitBoardMasks(boardDimension);
+    const BitSet *own = getColourBitSet(bitBoard, colour);
+    const BitSet *opponent = getOppositeBitSet(bitBoard, colour);
+    BitSet empty, run, next;
+    
+    for (int i = 0; i < numWords; i++) {
+        empty.words[i] = masks->onBoard.words[i] & ~(own->words[i] | opponent->words[i]);
+        moves->words[i] = 0;
+    }
+    
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        
+        //Start with opposite colour tiles next to the colour's tiles
+        shiftBitSet(own, &run, boardDimension, numWords, direction);
+        uint64_t any = 0;
+        for (int i = 0; i < numWords; i++) {
+            run.words[i] &= opponent->words[i];
+            any |= run.words[i];
+        }
+        
+        //Keep stepping until every run has ended, collecting the unoccupied positions runs end at
+        while (any != 0) {
+            shiftBitSet(&run, &next, boardDimension, numWords, direction);
+            any = 0;
+            for (int i = 0; i < numWords; i++) {
+                moves->words[i] |= next.words[i] & empty.words[i];
+                run.words[i] = next.words[i] & opponent->words[i];
+                any |= run.words[i];
+            }
+        }
+    }
+}
+
+#define DEFINE_FIND_MOVES(name, dimension) \
+    void findBitBoardMovesFor##name(BitBoard *bitBoard, char colour, BitSet *moves) { \
+        findMovesOfDimension(bitBoard, colour, moves, dimension); \
+    }
+FOR_EACH_EVEN_DIMENSION(DEFINE_FIND_MOVES)
+DEFINE_FIND_MOVES(Any, bitBoard->dimension)
+
+void (*const FIND_MOVES_KERNELS[MAX_DIMENSION + 1])(BitBoard *, char, BitSet *) = KERNEL_TABLE(findBitBoardMovesFor);
+
+/**Finds every valid position for a colour on a bit board in one pass
+ * In each direction, runs of opposite colour tiles touching the colour's tiles are grown one step at a time,
+ * any unoccupied position just past a run is a valid move
+ */
+void findBitBoardMoves(BitBoard *bitBoard, char colour, BitSet *moves) {
+    FIND_MOVES_KERNELS[bitBoard->dimension](bitBoard, colour, moves);
+}
+
+//Count number of valid positions on a bit board
+int countBitBoardMoves(BitBoard *bitBoard, char colour) {
+    BitSet moves;
+    findBitBoardMoves(bitBoard, colour, &moves);
+    return countBitSet(&moves, bitBoard->numWords);
+}
+
+/**Searches a bit board in the direction given, returns how many tiles can be flipped, zero if no move can be made
+ * The ray's length, from the position's ray lengths, stops the walk at the edge of the board, so no step is checked
+ * against the bounds, and each step is one constant move through the bit board
+ */
+ALWAYS_INLINE int searchOfDimension(BitBoard *bitBoard, int row, int col, char colour, int direction, int length,
+                                    int boardDimension)
+{
+    COUNT_STAT(raysWalked, 1);
+    const BitSet *own = getColourBitSet(bitBoard, colour);
+    const BitSet *opponent = getOppositeBitSet(bitBoard, colour);
+    int step = DELTA_ROW[direction] * boardDimension + DELTA_COL[direction];
+    
+    //Step in the direction given while positions hold the opposite colour
+    int tilesFlipped = 0;
+    int square = row * boardDimension + col;
+    while (tilesFlipped < length && bitSetContains(opponent, square += step)) {
+        tilesFlipped++;
+    }
+    
+    //If opposite colours were found, the run must end at one of the colour's tiles, the position the walk stopped at
+    if (tilesFlipped > 0 && tilesFlipped < length && bitSetContains(own, square)) {
+        return tilesFlipped;
+    }
+    return 0;
+}
+
+//Flips tiles on a bit board in the direction given
+ALWAYS_INLINE void flipOfDimension(BitBoard *bitBoard, int row, int col, int numFlips, char colour, int direction,
+                                   int boardDimension)
+{
+    COUNT_STAT(flipsApplied, numFlips);
+    BitSet *own = getColourBitSet(bitBoard, colour);
+    BitSet *opponent = getOppositeBitSet(bitBoard, colour);
+    
+    int step = DELTA_ROW[direction] * boardDimension + DELTA_COL[direction];
+    int square = row * boardDimension + col;
+    for (int i = 1; i <= numFlips; i++) {
+        square += step;
+        own->words[square / 64] |= 1ULL << (square % 64);
+        opponent->words[square / 64] &= ~(1ULL << (square % 64));
+    }
+}
+
+//Checks to see if a bit board is full
+bool isBitBoardFull(const BitBoard *bitBoard) {
+    BitSet empty;
+    findEmptyBitSet(bitBoard, &empty);
+    return isBitSetEmpty(&empty, bitBoard->numWords);
+}
+
+//Determines the winner of the game on a bit board, 0 if a draw
+char determineBitBoardWinner(const BitBoard *bitBoard) {
+    int numWhite = countBitSet(&bitBoard->white, bitBoard->numWords);
+    int numBlack = countBitSet(&bitBoard->black, bitBoard->numWords);
+    
+    if (numWhite == numBlack) {
+        return 0;
+    }
+    else if (numWhite > numBlack) {
+        return 'W';
+    }
+    else {
+        return 'B';
+    }
+}
+
+//Body of buildMove, for a board of the dimension given
+ALWAYS_INLINE void buildMoveOfDimension(BitBoard *bitBoard, int row, int col, char colour, Move *move, int boardDimension) {
+    move->row = row;
+    move->col = col;
+    
+    //Standard 8x8 boards count the flips in every direction at once on bitboards
+    if (boardDimension == 8) {
+        uint64_t flips = findFlipsOfBitboard8(getColourBitSet(bitBoard, colour)->words[0],
+                                              getOppositeBitSet(bitBoard, colour)->words[0], row * 8 + col,
+                                              move->numFlips);
+        move->totalFlips = countBits(flips);
+        return;
+    }
+    
+    const unsigned char *lengths = (*getRayLengths(boardDimension))[row][col];
+    move->totalFlips = 0;
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        move->numFlips[direction] = searchOfDimension(bitBoard, row, col, colour, direction, lengths[direction],
+                                                      boardDimension);
+        move->totalFlips += move->numFlips[direction];
+    }
+}
+
+#define DEFINE_BUILD_MOVE(name, dimension) \
+    void buildMoveFor##name(BitBoard *bitBoard, int row, int col, char colour, Move *move) { \
+        buildMoveOfDimension(bitBoard, row, col, colour, move, dimension); \
+    }
+FOR_EACH_EVEN_DIMENSION(DEFINE_BUILD_MOVE)
+DEFINE_BUILD_MOVE(Any, bitBoard->dimension)
+
+void (*const BUILD_MOVE_KERNELS[MAX_DIMENSION + 1])(BitBoard *, int, int, char, Move *) = KERNEL_TABLE(buildMoveFor);
+
+//Fills in a move at a position, counting the flips in each direction
+void buildMove(BitBoard *bitBoard, int row, int col, char colour, Move *move) {
+    BUILD_MOVE_KERNELS[bitBoard->dimension](bitBoard, row, col, colour, move);
+}
+
+/**Generates every valid move for a colour on a bit board in a single pass
+ * Valid positions are found all at once, then the flips in each direction are counted once per move
+ */
+void generateBitBoardMoves(BitBoard *bitBoard, char colour, MoveList *moveList) {
+    int boardDimension = bitBoard->dimension;
+    BitSet moves;
+    
+    //Standard 8x8 boards fit in a single word
+    if (boardDimension == 8) {
+        moves.words[0] = findMovesBitboard8(getColourBitSet(bitBoard, colour)->words[0],
+                                            getOppositeBitSet(bitBoard, colour)->words[0]);
+    }
+    else {
+        findBitBoardMoves(bitBoard, colour, &moves);
+    }
+    
+    //Record the flips of each valid position in the same order as the board
+    moveList->numMoves = 0;
+    for (int i = 0; i < bitBoard->numWords; i++) {
+        uint64_t word = moves.words[i];
+        while (word != 0) {
+            int square = i * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+            
+            buildMove(bitBoard, square / boardDimension, square % boardDimension, colour,
+                      &moveList->moves[moveList->numMoves++]);
+        }
+    }
+}
+
+//Generates every valid move for a colour on the board in a single pass
+void generateMoves(char board[][26], int boardDimension, char colour, MoveList *moveList) {
+    BitBoard bitBoard;
+    loadBitBoard(board, boardDimension, &bitBoard);
+    generateBitBoardMoves(&bitBoard, colour, moveList);
+}
+
+//Finds the move at a position in a list of moves, returns NULL if the position is not a valid move
+const Move *findMove(const MoveList *moveList, int row, int col) {
+    for (int i = 0; i < moveList->numMoves; i++) {
+        if (moveList->moves[i].row == row && moveList->moves[i].col == col) {
+            return &moveList->moves[i];
+        }
+    }
+    return NULL;
+}
+
+//Body of applyBitBoardMove, for a board of the dimension given
+ALWAYS_INLINE void applyMoveOfDimension(BitBoard *bitBoard, const Move *move, char colour, int boardDimension) {
+    
+    //Standard 8x8 boards flip every tile at once on bitboards
+    if (boardDimension == 8) {
+        uint64_t *own = &getColourBitSet(bitBoard, colour)->words[0];
+        uint64_t *opponent = &getOppositeBitSet(bitBoard, colour)->words[0];
+        uint64_t flips = findFlipsBitboard8(*own, *opponent, move->row * 8 + move->col);
+        COUNT_STAT(flipsApplied, countBits(flips));
+        *own |= flips | 1ULL << (move->row * 8 + move->col);
+        *opponent &= ~flips;
+        return;
+    }
+    
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        if (move->numFlips[direction] > 0) {
+            flipOfDimension(bitBoard, move->row, move->col, move->numFlips[direction], colour, direction, boardDimension);
+        }
+    }
+    addToBitSet(getColourBitSet(bitBoard, colour), move->row * boardDimension + move->col);
+}
+
+#define DEFINE_APPLY_MOVE(name, dimension) \
+    void applyBitBoardMoveFor##name(BitBoard *bitBoard, const Move *move, char colour) { \
+        applyMoveOfDimension(bitBoard, move, colour, dimension); \
+    }
+FOR_EACH_EVEN_DIMENSION(DEFINE_APPLY_MOVE)
+DEFINE_APPLY_MOVE(Any, bitBoard->dimension)
+
+void (*const APPLY_MOVE_KERNELS[MAX_DIMENSION + 1])(BitBoard *, const Move *, char) = KERNEL_TABLE(applyBitBoardMoveFor);
+
+//Makes a move from a list of moves on a bit board
+void applyBitBoardMove(BitBoard *bitBoard, const Move *move, char colour) {
+    APPLY_MOVE_KERNELS[bitBoard->dimension](bitBoard, move, colour);
+}
+
+//Makes a move from a list of moves on the board
+void applyMove(char board[][26], const Move *move, char colour) {
+    int row = move->row;
+    int col = move->col;
+    
+    //Make the flips that can be made
+    if (move->numFlips[NORTH] > 0) {
+        flipNorth(board, row, col, move->numFlips[NORTH], colour);
+    }
+    if (move->numFlips[NORTH_EAST] > 0) {
+        flipNorthEast(board, row, col, move->numFlips[NORTH_EAST], colour);
+    }
+    if (move->numFlips[EAST] > 0) {
+        flipEast(board, row, col, move->numFlips[EAST], colour);
+    }
+    if (move->numFlips[SOUTH_EAST] > 0) {
+        flipSouthEast(board, row, col, move->numFlips[SOUTH_EAST], colour);
+    }
+    if (move->numFlips[SOUTH] > 0) {
+        flipSouth(board, row, col, move->numFlips[SOUTH], colour);
+    }
+    if (move->numFlips[SOUTH_WEST] > 0) {
+        flipSouthWest(board, row, col, move->numFlips[SOUTH_WEST], colour);
+    }
+    if (move->numFlips[WEST] > 0) {
+        flipWest(board, row, col, move->numFlips[WEST], colour);
+    }
+    if (move->numFlips[NORTH_WEST] > 0) {
+        flipNorthWest(board, row, col, move->numFlips[NORTH_WEST], colour);
+    }
+    
+    //Place chip at chosen position
+    board[row][col] = colour;
+}
+
+//Gets the opposite of a colour
+char oppositeOf(char colour) {
+    return colour == 'W' ? 'B' : 'W';
+}
+
+//Gets the index of a colour in the Zobrist keys
+int colourIndex(char colour) {
+    return colour == 'W' ? 1 : 0;
+}
+
+//Generates the next number from a fixed sequence of random numbers (SplitMix64)
+uint64_t nextRandom(uint64_t *seed) {
+    uint64_t z = (*seed += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+//Fills the Zobrist keys, the keys are the same on every run so hashes can be saved
+void initZobristKeys(void) {
+    uint64_t seed = 0x0123456789ABCDEFULL;
+    for (int colour = 0; colour < 2; colour++) {
+        for (int square = 0; square < MAX_DIMENSION * MAX_DIMENSION; square++) {
+            zobristKeys[colour][square] = nextRandom(&seed);
+        }
+    }
+    zobristBlackToMove = nextRandom(&seed);
+}
+
+//Computes the Zobrist hash of a bit board with the colour given to move from scratch
+uint64_t computeBitBoardHash(const BitBoard *bitBoard, char turn) {
+    uint64_t hash = turn == 'B' ? zobristBlackToMove : 0;
+    for (int i = 0; i < bitBoard->numWords; i++) {
+        uint64_t white = bitBoard->white.words[i];
+        uint64_t black = bitBoard->black.words[i];
+        while (white != 0) {
+            hash ^= zobristKeys[1][i * 64 + __builtin_ctzll(white)];
+            white &= white - 1;
+        }
+        while (black != 0) {
+            hash ^= zobristKeys[0][i * 64 + __builtin_ctzll(black)];
+            black &= black - 1;
+        }
+    }
+    return hash;
+}
+
+//Computes the Zobrist hash of a game state from scratch
+uint64_t computeHash(const GameState *state) {
+    return computeBitBoardHash(&state->board, state->turn);
+}
+
+//Swaps the rows and columns of an 8x8 bitboard, three rounds of swapping blocks across the main diagonal
+uint64_t transposeBitboard8(uint64_t bits) {
+    uint64_t swapped = 0x0F0F0F0F00000000ULL & (bits ^ (bits << 28));
+    bits ^= swapped ^ (swapped >> 28);
+    swapped = 0x3333000033330000ULL & (bits ^ (bits << 14));
+    bits ^= swapped ^ (swapped >> 14);
+    swapped = 0x5500550055005500ULL & (bits ^ (bits << 7));
+    bits ^= swapped ^ (swapped >> 7);
+    return bits;
+}
+
+//Reverses the order of the columns of an 8x8 bitboard, the bits within each row's byte
+uint64_t mirrorBitboard8(uint64_t bits) {
+    bits = ((bits >> 1) & 0x5555555555555555ULL) | ((bits & 0x5555555555555555ULL) << 1);
+    bits = ((bits >> 2) & 0x3333333333333333ULL) | ((bits & 0x3333333333333333ULL) << 2);
+    bits = ((bits >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((bits & 0x0F0F0F0F0F0F0F0FULL) << 4);
+    return bits;
+}
+
+//Applies a symmetry to an 8x8 bitboard, reversing the rows is reversing the bytes
+uint64_t transformBitboard8(uint64_t bits, int symmetry) {
+    if (symmetry & SYMMETRY_TRANSPOSE) {
+        bits = transposeBitboard8(bits);
+    }
+    if (symmetry & SYMMETRY_FLIP_COLUMNS) {
+        bits = mirrorBitboard8(bits);
+    }
+    if (symmetry & SYMMETRY_FLIP_ROWS) {
+        bits = __builtin_bswap64(bits);
+    }
+    return bits;
+}
+
+//Finds where a symmetry moves a position, given and returned as (row * boardDimension + col)
+int transformSquare(int boardDimension, int symmetry, int square) {
+    int row = square / boardDimension;
+    int col = square % boardDimension;
+    if (symmetry & SYMMETRY_TRANSPOSE) {
+        int swapped = row;
+        row = col;
+        col = swapped;
+    }
+    if (symmetry & SYMMETRY_FLIP_COLUMNS) {
+        col = boardDimension - 1 - col;
+    }
+    if (symmetry & SYMMETRY_FLIP_ROWS) {
+        row = boardDimension - 1 - row;
+    }
+    return row * boardDimension + col;
+}
+
+/**Finds the symmetry that undoes another
+ * Every symmetry undoes itself except a transpose with one flip, which is undone by a transpose with the other flip
+ */
+int invertSymmetry(int symmetry) {
+    int flips = symmetry & (SYMMETRY_FLIP_COLUMNS | SYMMETRY_FLIP_ROWS);
+    if ((symmetry & SYMMETRY_TRANSPOSE) && (flips == SYMMETRY_FLIP_COLUMNS || flips == SYMMETRY_FLIP_ROWS)) {
+        return SYMMETRY_TRANSPOSE | (flips ^ (SYMMETRY_FLIP_COLUMNS | SYMMETRY_FLIP_ROWS));
+    }
+    return symmetry;
+}
+
+//Applies a symmetry to a bit board, with bit tricks on 8x8 boards and by moving each tile on other boards
+void transformBitBoard(const BitBoard *bitBoard, int symmetry, BitBoard *transformed) {
+    int boardDimension = bitBoard->dimension;
+    memset(transformed, 0, sizeof(BitBoard));
+    transformed->dimension = boardDimension;
+    transformed->numWords = bitBoard->numWords;
+    
+    if (boardDimension == 8) {
+        transformed->black.words[0] = transformBitboard8(bitBoard->black.words[0], symmetry);
+        transformed->white.words[0] = transformBitboard8(bitBoard->white.words[0], symmetry);
+        return;
+    }
+    for (int i = 0; i < bitBoard->numWords; i++) {
+        for (uint64_t bits = bitBoard->black.words[i]; bits != 0; bits &= bits - 1) {
+            addToBitSet(&transformed->black, transformSquare(boardDimension, symmetry, i * 64 + __builtin_ctzll(bits)));
+        }
+        for (uint64_t bits = bitBoard->white.words[i]; bits != 0; bits &= bits - 1) {
+            addToBitSet(&transformed->white, transformSquare(boardDimension, symmetry, i * 64 + __builtin_ctzll(bits)));
+        }
+    }
+}
+
+//Compares the tiles of two bit boards of the same dimension, Black's from the last word down, then White's
+int compareBitBoards(const BitBoard *first, const BitBoard *second) {
+    for (int i = first->numWords - 1; i >= 0; i--) {
+        if (first->black.words[i] != second->black.words[i]) {
+            return first->black.words[i] < second->black.words[i] ? -1 : 1;
+        }
+    }
+    for (int i = first->numWords - 1; i >= 0; i--) {
+        if (first->white.words[i] != second->white.words[i]) {
+            return first->white.words[i] < second->white.words[i] ? -1 : 1;
+        }
+    }
+    return 0;
+}
+
+/**Computes the Zobrist hash of a position's canonical form, the symmetry of it whose tiles compare lowest,
+ * so all eight rotations and reflections of a position share one hash
+ * Also gives the symmetry that maps the position to its canonical form, so moves can be mapped back with its inverse
+ */
+uint64_t computeCanonicalHash(const GameState *state, int *symmetry) {
+    BitBoard canonical = state->board, transformed;
+    *symmetry = 0;
+    for (int candidate = 1; candidate < NUM_SYMMETRIES; candidate++) {
+        transformBitBoard(&state->board, candidate, &transformed);
+        if (compareBitBoards(&transformed, &canonical) < 0) {
+            canonical = transformed;
+            *symmetry = candidate;
+        }
+    }
+    return computeBitBoardHash(&canonical, state->turn);
+}
+
+//Fills in the rest of a game state from its bit board, with an empty undo stack
+void startGameState(GameState *state, char turn) {
+    state->turn = turn;
+    state->hash = computeHash(state);
+    state->numDiscs[colourIndex('W')] = countBitSet(&state->board.white, state->board.numWords);
+    state->numDiscs[colourIndex('B')] = countBitSet(&state->board.black, state->board.numWords);
+    state->undoDepth = 0;
+}
+
+//Loads a board into a game state with the colour given to move
+void loadGameState(char board[][26], int boardDimension, char turn, GameState *state) {
+    loadBitBoard(board, boardDimension, &state->board);
+    startGameState(state, turn);
+}
+
+//Sets up a game state at the start of a game with the colour given to move
+void setupGameState(int boardDimension, char turn, GameState *state) {
+    setupBitBoard(&state->board, boardDimension);
+    startGameState(state, turn);
+}
+
+//Body of makeGameStateMove, for a board of the dimension given
+ALWAYS_INLINE void makeMoveOfDimension(GameState *state, const Move *move, int boardDimension) {
+    COUNT_STAT(flipsApplied, move->totalFlips);
+    int own = colourIndex(state->turn);
+    int opponent = 1 - own;
+    BitSet *ownBits = getColourBitSet(&state->board, state->turn);
+    BitSet *opponentBits = getOppositeBitSet(&state->board, state->turn);
+    
+    UndoRecord *record = &state->undoStack[state->undoDepth++];
+    record->move = *move;
+    record->hash = state->hash;
+    
+    //Standard 8x8 boards flip every tile at once on bitboards, then only the hash goes through the tiles one at a time
+    if (boardDimension == 8) {
+        uint64_t flips = findFlipsBitboard8(ownBits->words[0], opponentBits->words[0], move->row * 8 + move->col);
+        ownBits->words[0] |= flips;
+        opponentBits->words[0] &= ~flips;
+        while (flips != 0) {
+            int square = __builtin_ctzll(flips);
+            state->hash ^= zobristKeys[own][square] ^ zobristKeys[opponent][square];
+            flips &= flips - 1;
+        }
+    }
+    
+    //Each flipped tile leaves the opposite colour and joins the colour to move
+    else {
+        for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+            int step = DELTA_ROW[direction] * boardDimension + DELTA_COL[direction];
+            int square = move->row * boardDimension + move->col;
+            for (int i = 1; i <= move->numFlips[direction]; i++) {
+                square += step;
+                uint64_t bit = 1ULL << (square % 64);
+                ownBits->words[square / 64] |= bit;
+                opponentBits->words[square / 64] &= ~bit;
+                state->hash ^= zobristKeys[own][square] ^ zobristKeys[opponent][square];
+            }
+        }
+    }
+    
+    //Place the tile and pass the turn
+    int placed = move->row * boardDimension + move->col;
+    addToBitSet(ownBits, placed);
+    state->hash ^= zobristKeys[own][placed] ^ zobristBlackToMove;
+    state->numDiscs[own] += move->totalFlips + 1;
+    state->numDiscs[opponent] -= move->totalFlips;
+    state->turn = oppositeOf(state->turn);
+}
+
+#define DEFINE_MAKE_MOVE(name, dimension) \
+    void makeGameStateMoveFor##name(GameState *state, const Move *move) { \
+        makeMoveOfDimension(state, move, dimension); \
+    }
+FOR_EACH_EVEN_DIMENSION(DEFINE_MAKE_MOVE)
+DEFINE_MAKE_MOVE(Any, state->board.dimension)
+
+void (*const MAKE_MOVE_KERNELS[MAX_DIMENSION + 1])(GameState *, const Move *) = KERNEL_TABLE(makeGameStateMoveFor);
+
+/**Makes a move from a list of moves for the colour to move, then passes the turn to the other colour
+ * The move is pushed on the undo stack so it can be taken back exactly
+ */
+void makeGameStateMove(GameState *state, const Move *move) {
+    MAKE_MOVE_KERNELS[state->board.dimension](state, move);
+}
+
+//Passes the turn to the other colour when the colour to move has no valid move
+void passGameState(GameState *state) {
+    UndoRecord *record = &state->undoStack[state->undoDepth++];
+    record->move.row = -1;
+    record->hash = state->hash;
+    
+    state->hash ^= zobristBlackToMove;
+    state->turn = oppositeOf(state->turn);
+}
+
+//Takes back the last move or pass from the undo stack
+void undoGameStateMove(GameState *state) {
+    const UndoRecord *record = &state->undoStack[--state->undoDepth];
+    const Move *move = &record->move;
+    state->turn = oppositeOf(state->turn);
+    state->hash = record->hash;
+    if (move->row < 0) {
+        return;
+    }
+    
+    int boardDimension = state->board.dimension;
+    int own = colourIndex(state->turn);
+    BitSet *ownBits = getColourBitSet(&state->board, state->turn);
+    BitSet *opponentBits = getOppositeBitSet(&state->board, state->turn);
+    
+    //Give each flipped tile back to the opposite colour and remove the placed tile
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        for (int i = 1; i <= move->numFlips[direction]; i++) {
+            int square = (move->row + i * DELTA_ROW[direction]) * boardDimension + move->col + i * DELTA_COL[direction];
+            uint64_t bit = 1ULL << (square % 64);
+            ownBits->words[square / 64] &= ~bit;
+            opponentBits->words[square / 64] |= bit;
+        }
+    }
+    int placed = move->row * boardDimension + move->col;
+    ownBits->words[placed / 64] &= ~(1ULL << (placed % 64));
+    state->numDiscs[own] -= move->totalFlips + 1;
+    state->numDiscs[1 - own] += move->totalFlips;
+}
+
+//Body of isValidBitBoardMove, for a board of the dimension given
+ALWAYS_INLINE bool isValidMoveOfDimension(BitBoard *bitBoard, int row, int col, char colour, int boardDimension) {
+    const unsigned char *lengths = (*getRayLengths(boardDimension))[row][col];
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        if (searchOfDimension(bitBoard, row, col, colour, direction, lengths[direction], boardDimension) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#define DEFINE_IS_VALID_MOVE(name, dimension) \
+    bool isValidBitBoardMoveFor##name(BitBoard *bitBoard, int row, int col, char colour) { \
+        return isValidMoveOfDimension(bitBoard, row, col, colour, dimension); \
+    }
+FOR_EACH_EVEN_DIMENSION(DEFINE_IS_VALID_MOVE)
+DEFINE_IS_VALID_MOVE(Any, bitBoard->dimension)
+
+bool (*const IS_VALID_MOVE_KERNELS[MAX_DIMENSION + 1])(BitBoard *, int, int, char) = KERNEL_TABLE(isValidBitBoardMoveFor);
+
+//Checks to see if a position is a valid move for a colour on a bit board
+bool isValidBitBoardMove(BitBoard *bitBoard, int row, int col, char colour) {
+    return IS_VALID_MOVE_KERNELS[bitBoard->dimension](bitBoard, row, col, colour);
+}
+
+//Gets the tracker masks for a board dimension, building them when the dimension changes
+const TrackerMasks *getTrackerMasks(int boardDimension) {
+    if (trackerMasks.dimension == boardDimension) {
+        return &trackerMasks;
+    }
+    
+    memset(&trackerMasks, 0, sizeof(trackerMasks));
+    trackerMasks.dimension = boardDimension;
+    const RayLengths *lengths = getRayLengths(boardDimension);
+    for (int row = 0; row < boardDimension; row++) {
+        for (int col = 0; col < boardDimension; col++) {
+            int square = row * boardDimension + col;
+            
+            //Walk every ray out to the edge of the board, its length says how far that is
+            for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+                int length = (*lengths)[row][col][direction];
+                int step = DELTA_ROW[direction] * boardDimension + DELTA_COL[direction];
+                if (length > 0) {
+                    addToBitSet(&trackerMasks.neighbours[square], square + step);
+                }
+                for (int i = 1; i <= length; i++) {
+                    addToBitSet(&trackerMasks.lines[square], square + i * step);
+                }
+            }
+        }
+    }
+    return &trackerMasks;
+}
+
+//Checks each position in a set of frontier positions again, updating the valid moves of both colours
+void recheckTrackedPositions(GameState *state, MoveTracker *tracker, const BitSet *positions) {
+    int boardDimension = state->board.dimension;
+    
+    for (int i = 0; i < state->board.numWords; i++) {
+        uint64_t word = positions->words[i];
+        while (word != 0) {
+            int square = i * 64 + __builtin_ctzll(word);
+            uint64_t bit = word & -word;
+            word &= word - 1;
+            
+            for (int colour = 0; colour < 2; colour++) {
+                char colourChar = colour == 1 ? 'W' : 'B';
+                if (isValidBitBoardMove(&state->board, square / boardDimension, square % boardDimension, colourChar)) {
+                    tracker->valid[colour].words[i] |= bit;
+                }
+                else {
+                    tracker->valid[colour].words[i] &= ~bit;
+                }
+            }
+        }
+    }
+    
+    tracker->numValid[0] = countBitSet(&tracker->valid[0], state->board.numWords);
+    tracker->numValid[1] = countBitSet(&tracker->valid[1], state->board.numWords);
+}
+
+//Starts tracking the valid moves of a game state, checking every frontier position once
+void startMoveTracker(GameState *state, MoveTracker *tracker) {
+    int numWords = state->board.numWords;
+    BitSet empty, occupied, shifted;
+    memset(tracker, 0, sizeof(*tracker));
+    findEmptyBitSet(&state->board, &empty);
+    
+    //The frontier is every unoccupied position next to a tile
+    for (int i = 0; i < numWords; i++) {
+        occupied.words[i] = state->board.white.words[i] | state->board.black.words[i];
+    }
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        shiftBitSet(&occupied, &shifted, state->board.dimension, numWords, direction);
+        for (int i = 0; i < numWords; i++) {
+            tracker->frontier.words[i] |= shifted.words[i] & empty.words[i];
+        }
+    }
+    
+    recheckTrackedPositions(state, tracker, &tracker->frontier);
+}
+
+/**Updates the tracked valid moves after a move has been made on the game state
+ * Only frontier positions that share a row, column or diagonal with the placed tile or a flipped tile are checked again
+ */
+void updateMoveTracker(GameState *state, MoveTracker *tracker, const Move *move) {
+    int boardDimension = state->board.dimension;
+    int numWords = state->board.numWords;
+    const TrackerMasks *masks = getTrackerMasks(boardDimension);
+    int placed = move->row * boardDimension + move->col;
+    BitSet empty, recheck = masks->lines[placed];
+    findEmptyBitSet(&state->board, &empty);
+    
+    //The placed tile leaves the frontier, and the unoccupied positions next to it join
+    for (int i = 0; i < numWords; i++) {
+        tracker->frontier.words[i] = (tracker->frontier.words[i] | masks->neighbours[placed].words[i]) & empty.words[i];
+        tracker->valid[0].words[i] &= empty.words[i];
+        tracker->valid[1].words[i] &= empty.words[i];
+    }
+    
+    //Collect the lines through every flipped tile
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        for (int j = 1; j <= move->numFlips[direction]; j++) {
+            int square = (move->row + j * DELTA_ROW[direction]) * boardDimension + move->col + j * DELTA_COL[direction];
+            for (int i = 0; i < numWords; i++) {
+                recheck.words[i] |= masks->lines[square].words[i];
+            }
+        }
+    }
+    for (int i = 0; i < numWords; i++) {
+        recheck.words[i] &= tracker->frontier.words[i];
+    }
+    
+    recheckTrackedPositions(state, tracker, &recheck);
+}
+
+//Generates the moves for a colour from the positions the tracker knows are valid
+void generateTrackedMoves(GameState *state, const MoveTracker *tracker, char colour, MoveList *moveList) {
+    COUNT_STAT(moveGenerations, 1);
+    int boardDimension = state->board.dimension;
+    const BitSet *valid = &tracker->valid[colourIndex(colour)];
+    
+    moveList->numMoves = 0;
+    for (int i = 0; i < state->board.numWords; i++) {
+        uint64_t word = valid->words[i];
+        while (word != 0) {
+            int square = i * 64 + __builtin_ctzll(word);
+            word &= word - 1;
+            buildMove(&state->board, square / boardDimension, square % boardDimension, colour,
+                      &moveList->moves[moveList->numMoves++]);
+        }
+    }
+}
+
+//Allocates the hash table, rounding its size down to a power of two entries, returns false if memory runs out
+bool createHashTable(HashTable *table, int megabytes) {
+    uint64_t numEntries = 1;
+    while (numEntries * 2 * sizeof(HashSlot) <= (uint64_t) megabytes * 1024 * 1024) {
+        numEntries *= 2;
+    }
+    
+    table->slots = calloc(numEntries, sizeof(HashSlot));
+    table->mask = numEntries - 1;
+    return table->slots != NULL;
+}
+
+//Empties the hash table, so no search finds what an earlier one stored
+void clearHashTable(HashTable *table) {
+    if (table->slots != NULL) {
+        memset(table->slots, 0, (table->mask + 1) * sizeof(HashSlot));
+    }
+    table->generation = 0;
+}
+
+//Packs the result of a search into one word
+uint64_t packHashEntry(const HashEntry *entry) {
+    return (uint64_t) (uint32_t) entry->score |
+           (uint64_t) (uint16_t) entry->bestSquare << 32 |
+           (uint64_t) entry->depth << 48 |
+           (uint64_t) entry->bound << 56 |
+           (uint64_t) (entry->generation & 0x3F) << 58;
+}
+
+//Unpacks the result of a search from one word
+void unpackHashEntry(uint64_t data, HashEntry *entry) {
+    entry->score = (int32_t) (uint32_t) data;
+    entry->bestSquare = (int16_t) (uint16_t) (data >> 32);
+    entry->depth = (data >> 48) & 0xFF;
+    entry->bound = (data >> 56) & 0x3;
+    entry->generation = data >> 58;
+}
+
+/**Finds the key a position is stored under in the hash table, and the symmetry that maps its moves to stored ones
+ * Early positions, which are often reached through mirrored move orders, share the key of their canonical form
+ */
+uint64_t findHashKey(const GameState *state, int *symmetry) {
+    if (state->numDiscs[0] + state->numDiscs[1] <= CANONICAL_HASH_DISCS) {
+        return computeCanonicalHash(state, symmetry);
+    }
+    *symmetry = 0;
+    return state->hash;
+}
+
+//Looks up a position in the hash table, returns false if the position is not stored
+bool probeHashTable(HashTable *table, uint64_t key, HashEntry *entry, SearchInfo *info) {
+    if (table->slots == NULL) {
+        return false;
+    }
+    
+    HashSlot *slot = &table->slots[key & table->mask];
+    uint64_t data = atomic_load_explicit(&slot->data, memory_order_relaxed);
+    uint64_t check = atomic_load_explicit(&slot->check, memory_order_relaxed);
+    info->hashProbes++;
+    COUNT_STAT(hashProbes, 1);
+    if (data == 0) {
+        return false;
+    }
+    if ((check ^ data) != key) {
+        info->hashCollisions++;
+        return false;
+    }
+    
+    info->hashHits++;
+    COUNT_STAT(hashHits, 1);
+    unpackHashEntry(data, entry);
+    return true;
+}
+
+//Stores the result of searching a position, following the table's replacement policy
+void storeHashTable(HashTable *table, uint64_t key, int depth, int bound, int score, int bestSquare, SearchInfo *info) {
+    if (table->slots == NULL) {
+        return;
+    }
+    
+    HashSlot *slot = &table->slots[key & table->mask];
+    uint64_t oldData = atomic_load_explicit(&slot->data, memory_order_relaxed);
+    uint64_t oldCheck = atomic_load_explicit(&slot->check, memory_order_relaxed);
+    HashEntry old;
+    unpackHashEntry(oldData, &old);
+    bool samePosition = oldData != 0 && (oldCheck ^ oldData) == key;
+    if (oldData != 0 && !samePosition && old.generation == (table->generation & 0x3F) && old.depth > depth) {
+        return;
+    }
+    
+    info->hashStores++;
+    if (oldData != 0 && !samePosition) {
+        info->hashOverwrites++;
+    }
+    
+    //Keep the old best move if this search did not find one
+    HashEntry entry = {score, bestSquare, depth, bound, table->generation};
+    if (bestSquare < 0 && samePosition) {
+        entry.bestSquare = old.bestSquare;
+    }
+    uint64_t data = packHashEntry(&entry);
+    atomic_store_explicit(&slot->check, key ^ data, memory_order_relaxed);
+    atomic_store_explicit(&slot->data, data, memory_order_relaxed);
+}
+
+//Adds the hash table usage counted by a search to the table's totals
+void addHashTableStats(HashTable *table, const SearchInfo *info) {
+    table->probes += info->hashProbes;
+    table->hits += info->hashHits;
+    table->collisions += info->hashCollisions;
+    table->stores += info->hashStores;
+    table->overwrites += info->hashOverwrites;
+}
+
+//Prints how the hash table has been used
+void printHashTableStats(const HashTable *table) {
+    long long probes = table->probes > 0 ? table->probes : 1;
+    fprintf(stderr, "Hash table: %llu entries (%llu KB), %lld probes, %.1f%% hits, %.1f%% collisions, %lld stores, %lld overwrites\n",
+            (unsigned long long) (table->mask + 1), (unsigned long long) ((table->mask + 1) * sizeof(HashSlot) / 1024),
+            table->probes, 100.0 * table->hits / probes, 100.0 * table->collisions / probes,
+            table->stores, table->overwrites);
+}
+
+/**Gives a move a class for ordering: corners first, then ordinary moves, then C squares and then X squares next to an
+ * unoccupied corner, which usually give the corner away
+ */
+int classifyMove(const BitBoard *bitBoard, int row, int col) {
+    int last = bitBoard->dimension - 1;
+    bool rowEdge = row == 0 || row == last;
+    bool colEdge = col == 0 || col == last;
+    if (rowEdge && colEdge) {
+        return 2;
+    }
+    
+    //Only squares next to a corner can give it away
+    bool rowNear = row <= 1 || row >= last - 1;
+    bool colNear = col <= 1 || col >= last - 1;
+    if (!rowNear || !colNear) {
+        return 0;
+    }
+    int corner = (row <= 1 ? 0 : last) * bitBoard->dimension + (col <= 1 ? 0 : last);
+    if (bitSetContains(&bitBoard->white, corner) || bitSetContains(&bitBoard->black, corner)) {
+        return 0;
+    }
+    return rowEdge || colEdge ? -1 : -2;
+}
+
+/**Scores each move in a list for ordering, higher first: the hash move, then the killer moves of this ply, then by
+ * class, then by how few replies the move leaves the opponent (only near the root, where it is worth the cost),
+ * then by the history of cutoffs the move has caused
+ */
+void scoreMoves(GameState *state, const MoveList *moves, int hashSquare, int depth, SearchInfo *info, long long scores[]) {
+    int boardDimension = state->board.dimension;
+    int ply = state->undoDepth - info->rootUndoDepth;
+    const int *killers = info->killers[ply < MAX_PLY ? ply : MAX_PLY - 1];
+    const int *history = info->history[colourIndex(state->turn)];
+    
+    for (int i = 0; i < moves->numMoves; i++) {
+        const Move *move = &moves->moves[i];
+        int square = move->row * boardDimension + move->col;
+        if (square == hashSquare) {
+            scores[i] = 3LL << 40;
+        }
+        else if (square == killers[0]) {
+            scores[i] = 2LL << 40;
+        }
+        else if (square == killers[1]) {
+            scores[i] = 1LL << 40;
+        }
+        else {
+            scores[i] = classifyMove(&state->board, move->row, move->col) * (1LL << 32);
+            if (depth >= MOBILITY_ORDER_DEPTH) {
+                makeGameStateMove(state, move);
+                scores[i] -= (long long) countBitBoardMoves(&state->board, state->turn) << 24;
+                undoGameStateMove(state);
+            }
+            scores[i] += history[square];
+        }
+    }
+}
+
+//Swaps the highest scored move from the index given onwards into that index, so moves are only sorted as far as they are searched
+void pickNextMove(MoveList *moves, long long scores[], int index) {
+    int best = index;
+    for (int i = index + 1; i < moves->numMoves; i++) {
+        if (scores[i] > scores[best]) {
+            best = i;
+        }
+    }
+    if (best != index) {
+        Move move = moves->moves[index];
+        moves->moves[index] = moves->moves[best];
+        moves->moves[best] = move;
+        long long score = scores[index];
+        scores[index] = scores[best];
+        scores[best] = score;
+    }
+}
+
+/**Records a move that caused a cutoff: counts where it came in the order, makes it a killer move at its ply,
+ * and adds to its history, more for deeper searches
+ */
+void recordCutoff(const GameState *state, const Move *move, int index, int depth, SearchInfo *info) {
+    int boardDimension = state->board.dimension;
+    int square = move->row * boardDimension + move->col;
+    int ply = state->undoDepth - info->rootUndoDepth;
+    int *killers = info->killers[ply < MAX_PLY ? ply : MAX_PLY - 1];
+    int *history = info->history[colourIndex(state->turn)];
+    
+    info->cutoffs++;
+    info->cutoffIndexSum += index;
+    if (index == 0) {
+        info->firstMoveCutoffs++;
+    }
+    
+    if (killers[0] != square) {
+        killers[1] = killers[0];
+        killers[0] = square;
+    }
+    
+    //Halve the colour's history once it grows large, so recent cutoffs count for more
+    history[square] += depth * depth;
+    if (history[square] > MAX_HISTORY) {
+        for (int i = 0; i < boardDimension * boardDimension; i++) {
+            history[i] /= 2;
+        }
+    }
+}
+
+//Scores a finished game for the colour to move, a win always outscores a loss
+int scoreFinishedGame(GameState *state) {
+    int own = colourIndex(state->turn);
+    int discDifference = state->numDiscs[own] - state->numDiscs[1 - own];
+    
+    if (discDifference > 0) {
+        return WIN_SCORE + discDifference;
+    }
+    else if (discDifference < 0) {
+        return -WIN_SCORE + discDifference;
+    }
+    return 0;
+}
+
+//Finds a square from its row and col counted from one of the corners, swapping them first if the pattern is transposed
+int patternSquare(int boardDimension, int corner, bool transposed, int row, int col) {
+    if (transposed) {
+        int swap = row;
+        row = col;
+        col = swap;
+    }
+    if (corner & 2) {
+        row = boardDimension - 1 - row;
+    }
+    if (corner & 1) {
+        col = boardDimension - 1 - col;
+    }
+    return row * boardDimension + col;
+}
+
+/**Adds a pattern shape to an evaluator, described by the rows and cols of its squares counted from the top-left corner
+ * The shape is placed in the corners and orientations given, the weights are filled in once every shape is added
+ */
+void addPatternShape(PatternEvaluator *evaluator, int boardDimension, int numSquares, const int rows[], const int cols[],
+                     const unsigned char roles[], const signed char corners[], int lineLength, const int placements[][2],
+                     int numPlacements)
+{
+    PatternTable *table = &evaluator->tables[evaluator->numTables];
+    table->numSquares = numSquares;
+    table->lineLength = lineLength;
+    memcpy(table->roles, roles, numSquares);
+    memcpy(table->corners, corners, numSquares);
+    
+    for (int i = 0; i < numPlacements; i++) {
+        Pattern *pattern = &evaluator->patterns[evaluator->numPatterns++];
+        pattern->table = evaluator->numTables;
+        pattern->numSquares = numSquares;
+        for (int k = 0; k < numSquares; k++) {
+            pattern->squares[k] = patternSquare(boardDimension, placements[i][0], placements[i][1], rows[k], cols[k]);
+        }
+    }
+    evaluator->numTables++;
+}
+
+/**Works out the weight of one arrangement of tiles on a pattern for the colour to move
+ * Corners are worth holding, X and C squares next to an unoccupied corner give the corner away, edges are worth a little,
+ * and tiles along an edge that can no longer be flipped are worth more
+ */
+int scorePatternArrangement(const PatternTable *table, const int tiles[]) {
+    const int CORNER_WEIGHT = 8, X_WEIGHT = -6, C_WEIGHT = -3, EDGE_WEIGHT = 1, STABLE_WEIGHT = 2;
+    int score = 0;
+    
+    for (int k = 0; k < table->numSquares; k++) {
+        int sign = tiles[k] == 1 ? 1 : tiles[k] == 2 ? -1 : 0;
+        bool cornerEmpty = table->corners[k] >= 0 && tiles[table->corners[k]] == 0;
+        switch (table->roles[k]) {
+            case ROLE_CORNER:
+                score += sign * CORNER_WEIGHT;
+                break;
+            case ROLE_X:
+                score += cornerEmpty ? sign * X_WEIGHT : 0;
+                break;
+            case ROLE_C:
+                score += cornerEmpty ? sign * C_WEIGHT : sign * EDGE_WEIGHT;
+                break;
+            case ROLE_EDGE:
+                score += sign * EDGE_WEIGHT;
+                break;
+            default:
+                break;
+        }
+    }
+    
+    //Tiles in an unbroken run from an occupied corner along the edge, or on a full edge, cannot be flipped
+    int length = table->lineLength;
+    if (length > 0) {
+        bool stable[MAX_PATTERN_SQUARES] = {false};
+        bool full = true;
+        for (int k = 0; k < length; k++) {
+            full = full && tiles[k] != 0;
+        }
+        for (int k = 0; k < length && tiles[0] != 0 && tiles[k] == tiles[0]; k++) {
+            stable[k] = true;
+        }
+        if (table->roles[length - 1] == ROLE_CORNER) {
+            for (int k = length - 1; k >= 0 && tiles[length - 1] != 0 && tiles[k] == tiles[length - 1]; k--) {
+                stable[k] = true;
+            }
+        }
+        for (int k = 0; k < length; k++) {
+            if (stable[k] || full) {
+                score += (tiles[k] == 1 ? 1 : -1) * STABLE_WEIGHT;
+            }
+        }
+    }
+    return score;
+}
+
+/**Gets the patterns for a board dimension, building them and their weights the first time the dimension is used
+ * Every board gets its corner regions (3x3 and 2x5) and its edges with the X squares, boards up to 8x8 get whole edges
+ * and diagonals, larger boards get the 8 squares of each edge and diagonal nearest each corner
+ */
+const PatternEvaluator *getPatternEvaluator(int boardDimension) {
+    PatternEvaluator *evaluator = &patternEvaluators[boardDimension];
+    if (evaluator->initialized) {
+        return evaluator;
+    }
+    
+    const int CORNERS[4][2] = {{0, false}, {1, false}, {2, false}, {3, false}};
+    const int CORNERS_BOTH_WAYS[8][2] = {{0, false}, {0, true}, {1, false}, {1, true},
+                                         {2, false}, {2, true}, {3, false}, {3, true}};
+    const int EDGES[4][2] = {{0, false}, {0, true}, {3, false}, {3, true}};
+    const int DIAGONALS[2][2] = {{0, false}, {1, false}};
+    int rows[MAX_PATTERN_SQUARES], cols[MAX_PATTERN_SQUARES];
+    unsigned char roles[MAX_PATTERN_SQUARES];
+    signed char corners[MAX_PATTERN_SQUARES];
+    int last = boardDimension - 1;
+    
+    //3x3 corner region
+    for (int k = 0; k < 9; k++) {
+        rows[k] = k / 3;
+        cols[k] = k % 3;
+        roles[k] = k == 0 ? ROLE_CORNER : k == 4 ? ROLE_X : (k == 1 || k == 3) ? ROLE_C : (k == 2 || k == 6) ? ROLE_EDGE : ROLE_INNER;
+        corners[k] = (roles[k] == ROLE_X || roles[k] == ROLE_C) ? 0 : -1;
+    }
+    addPatternShape(evaluator, boardDimension, 9, rows, cols, roles, corners, 0, CORNERS, 4);
+    
+    //2x5 corner region along each edge, narrower on small boards
+    int width = boardDimension < 5 ? boardDimension : 5;
+    for (int k = 0; k < 2 * width; k++) {
+        rows[k] = k / width;
+        cols[k] = k % width;
+        roles[k] = k == 0 ? ROLE_CORNER : (k == 1 || k == width) ? ROLE_C : k == width + 1 ? ROLE_X : k < width ? ROLE_EDGE : ROLE_INNER;
+        corners[k] = (roles[k] == ROLE_X || roles[k] == ROLE_C) ? 0 : -1;
+    }
+    addPatternShape(evaluator, boardDimension, 2 * width, rows, cols, roles, corners, width, CORNERS_BOTH_WAYS, 8);
+    
+    if (boardDimension <= 8) {
+        
+        //Whole edge along with both X squares
+        for (int k = 0; k < boardDimension; k++) {
+            rows[k] = 0;
+            cols[k] = k;
+            roles[k] = (k == 0 || k == last) ? ROLE_CORNER : (k == 1 || k == last - 1) ? ROLE_C : ROLE_EDGE;
+            corners[k] = k == 1 ? 0 : k == last - 1 ? last : -1;
+        }
+        rows[boardDimension] = rows[boardDimension + 1] = 1;
+        cols[boardDimension] = 1;
+        cols[boardDimension + 1] = last - 1;
+        roles[boardDimension] = roles[boardDimension + 1] = ROLE_X;
+        corners[boardDimension] = 0;
+        corners[boardDimension + 1] = last;
+        addPatternShape(evaluator, boardDimension, boardDimension + 2, rows, cols, roles, corners, boardDimension, EDGES, 4);
+        
+        //Both main diagonals
+        for (int k = 0; k < boardDimension; k++) {
+            rows[k] = cols[k] = k;
+            roles[k] = (k == 0 || k == last) ? ROLE_CORNER : (k == 1 || k == last - 1) ? ROLE_X : ROLE_INNER;
+            corners[k] = k == 1 ? 0 : k == last - 1 ? last : -1;
+        }
+        addPatternShape(evaluator, boardDimension, boardDimension, rows, cols, roles, corners, 0, DIAGONALS, 2);
+        
+        //Diagonals next to the main diagonals, which run between two C squares
+        for (int k = 0; k < last; k++) {
+            rows[k] = k;
+            cols[k] = k + 1;
+            roles[k] = (k == 0 || k == last - 1) ? ROLE_EDGE : ROLE_INNER;
+            corners[k] = -1;
+        }
+        addPatternShape(evaluator, boardDimension, last, rows, cols, roles, corners, 0, CORNERS_BOTH_WAYS, 4);
+    }
+    else {
+        
+        //The 8 squares of an edge nearest a corner, along with the X square
+        for (int k = 0; k < 8; k++) {
+            rows[k] = 0;
+            cols[k] = k;
+            roles[k] = k == 0 ? ROLE_CORNER : k == 1 ? ROLE_C : ROLE_EDGE;
+            corners[k] = k == 1 ? 0 : -1;
+        }
+        rows[8] = cols[8] = 1;
+        roles[8] = ROLE_X;
+        corners[8] = 0;
+        addPatternShape(evaluator, boardDimension, 9, rows, cols, roles, corners, 8, CORNERS_BOTH_WAYS, 8);
+        
+        //The 8 squares of a main diagonal nearest a corner
+        for (int k = 0; k < 8; k++) {
+            rows[k] = cols[k] = k;
+            roles[k] = k == 0 ? ROLE_CORNER : k == 1 ? ROLE_X : ROLE_INNER;
+            corners[k] = k == 1 ? 0 : -1;
+        }
+        addPatternShape(evaluator, boardDimension, 8, rows, cols, roles, corners, 0, CORNERS, 4);
+    }
+    
+    //Fill in the weights of every arrangement of every shape in one block
+    int totalWeights = 0;
+    for (int i = 0; i < evaluator->numTables; i++) {
+        int size = 1;
+        for (int k = 0; k < evaluator->tables[i].numSquares; k++) {
+            size *= 3;
+        }
+        evaluator->tables[i].offset = totalWeights;
+        totalWeights += size;
+    }
+    evaluator->weights = malloc(totalWeights * sizeof(int16_t));
+    for (int i = 0; evaluator->weights != NULL && i < evaluator->numTables; i++) {
+        const PatternTable *table = &evaluator->tables[i];
+        int tiles[MAX_PATTERN_SQUARES] = {0};
+        int size = (i + 1 < evaluator->numTables ? evaluator->tables[i + 1].offset : totalWeights) - table->offset;
+        for (int index = 0; index < size; index++) {
+            evaluator->weights[table->offset + index] = scorePatternArrangement(table, tiles);
+            
+            //Count up in base 3, the first square being the lowest digit
+            for (int k = 0; k < table->numSquares && ++tiles[k] == 3; k++) {
+                tiles[k] = 0;
+            }
+        }
+    }
+    evaluator->initialized = true;
+    return evaluator;
+}
+
+/**Scores a position for the colour to move from its patterns, the difference in valid moves, and parity
+ * Each pattern is one lookup of the weight of its arrangement of tiles
+ */
+int evaluateGameState(GameState *state) {
+    const int MOBILITY_WEIGHT = 3, PARITY_WEIGHT = 2;
+    const PatternEvaluator *evaluator = getPatternEvaluator(state->board.dimension);
+    const uint64_t *own = getColourBitSet(&state->board, state->turn)->words;
+    const uint64_t *opponent = getOppositeBitSet(&state->board, state->turn)->words;
+    int score = 0;
+    
+    for (int i = 0; i < evaluator->numPatterns; i++) {
+        const Pattern *pattern = &evaluator->patterns[i];
+        int index = 0;
+        for (int k = pattern->numSquares - 1; k >= 0; k--) {
+            int square = pattern->squares[k];
+            index = index * 3 + (int) (own[square >> 6] >> (square & 63) & 1) + 2 * (int) (opponent[square >> 6] >> (square & 63) & 1);
+        }
+        score += evaluator->weights[evaluator->tables[pattern->table].offset + index];
+    }
+    
+    //Standard 8x8 boards fit in a single word
+    int mobility = 0;
+    if (state->board.dimension == 8) {
+        mobility = countBits(findMovesBitboard8(own[0], opponent[0])) - countBits(findMovesBitboard8(opponent[0], own[0]));
+    }
+    else {
+        mobility = countBitBoardMoves(&state->board, state->turn) - countBitBoardMoves(&state->board, oppositeOf(state->turn));
+    }
+    score += MOBILITY_WEIGHT * mobility;
+    
+    //With an odd number of unoccupied positions left, the colour to move expects to make the last move
+    int numEmpty = state->board.dimension * state->board.dimension - state->numDiscs[0] - state->numDiscs[1];
+    if (numEmpty % 2 == 1) {
+        score += PARITY_WEIGHT;
+    }
+    return score;
+}
+
+//Gets the time in seconds from a steady clock
+double getSeconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec / 1e9;
+}
+
+#ifdef OTHELLO_STATS
+Stats collectedStats; //Counts of every thread, up to each one's last collection
+pthread_mutex_t statsLock = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+//Adds the calling thread's counts to the shared total and starts them again from zero, threads call this before they finish
+void collectThreadStats(void) {
+#ifdef OTHELLO_STATS
+    pthread_mutex_lock(&statsLock);
+    collectedStats.moveGenerations += threadStats.moveGenerations;
+    collectedStats.raysWalked += threadStats.raysWalked;
+    collectedStats.boundsChecks += threadStats.boundsChecks;
+    collectedStats.flipsApplied += threadStats.flipsApplied;
+    collectedStats.nodes += threadStats.nodes;
+    collectedStats.endgameNodes += threadStats.endgameNodes;
+    collectedStats.hashProbes += threadStats.hashProbes;
+    collectedStats.hashHits += threadStats.hashHits;
+    collectedStats.playouts += threadStats.playouts;
+    pthread_mutex_unlock(&statsLock);
+    memset(&threadStats, 0, sizeof(Stats));
+#endif
+}
+
+#ifdef OTHELLO_STATS
+//Gets the total counts so far, the calling thread's included, with the CPU time used by every thread
+void snapshotStats(Stats *stats, double *cpuSeconds) {
+    collectThreadStats();
+    pthread_mutex_lock(&statsLock);
+    *stats = collectedStats;
+    pthread_mutex_unlock(&statsLock);
+    
+    struct timespec now;
+    clock_gettime(CLOCK_PROCESS_CPUTIME_ID, &now);
+    *cpuSeconds = now.tv_sec + now.tv_nsec / 1e9;
+}
+
+/**Writes the counts between two snapshots as one line of JSON on stderr
+ * The line starts with its kind, "move" or "game", and move lines also give the ply the move was made at
+ */
+void printStatsJson(const char *kind, int ply, const Stats *start, const Stats *end, double wallSeconds,
+                    double cpuSeconds)
+{
+    fprintf(stderr, "{\"stats\":\"%s\"", kind);
+    if (ply > 0) {
+        fprintf(stderr, ",\"ply\":%d", ply);
+    }
+    fprintf(stderr, ",\"wall_ms\":%.3f,\"cpu_ms\":%.3f", wallSeconds * 1000, cpuSeconds * 1000);
+    fprintf(stderr, ",\"move_generations\":%lld", end->moveGenerations - start->moveGenerations);
+    fprintf(stderr, ",\"rays_walked\":%lld", end->raysWalked - start->raysWalked);
+    fprintf(stderr, ",\"bounds_checks\":%lld", end->boundsChecks - start->boundsChecks);
+    fprintf(stderr, ",\"flips_applied\":%lld", end->flipsApplied - start->flipsApplied);
+    fprintf(stderr, ",\"nodes\":%lld", end->nodes - start->nodes);
+    fprintf(stderr, ",\"endgame_nodes\":%lld", end->endgameNodes - start->endgameNodes);
+    fprintf(stderr, ",\"hash_probes\":%lld", end->hashProbes - start->hashProbes);
+    fprintf(stderr, ",\"hash_hits\":%lld", end->hashHits - start->hashHits);
+    fprintf(stderr, ",\"playouts\":%lld}\n", end->playouts - start->playouts);
+}
+#endif
+
+//Thread that sets a stop flag once a deadline passes, unless it is cancelled first
+typedef struct {
+    atomic_bool *stop;
+    double deadline; //From getSeconds
+    bool cancelled;
+    bool started;
+    pthread_mutex_t lock;
+    pthread_cond_t wake; //Signalled when the watchdog is cancelled
+    pthread_t thread;
+} Watchdog;
+
+//Sleeps until the deadline or until cancelled, the condition waits on the same steady clock as getSeconds
+void *runWatchdog(void *argument) {
+    Watchdog *watchdog = argument;
+    struct timespec until;
+    until.tv_sec = (time_t) watchdog->deadline;
+    until.tv_nsec = (long) ((watchdog->deadline - until.tv_sec) * 1e9);
+    if (until.tv_nsec >= 1000000000) {
+        until.tv_sec++;
+        until.tv_nsec -= 1000000000;
+    }
+    
+    pthread_mutex_lock(&watchdog->lock);
+    while (!watchdog->cancelled) {
+        if (pthread_cond_timedwait(&watchdog->wake, &watchdog->lock, &until) == ETIMEDOUT) {
+            atomic_store(watchdog->stop, true);
+            break;
+        }
+    }
+    pthread_mutex_unlock(&watchdog->lock);
+    return NULL;
+}
+
+//Starts a watchdog that sets the stop flag at the deadline, returns false if its thread could not be started
+bool startWatchdog(Watchdog *watchdog, atomic_bool *stop, double deadline) {
+    pthread_condattr_t attributes;
+    pthread_condattr_init(&attributes);
+    pthread_condattr_setclock(&attributes, CLOCK_MONOTONIC);
+    pthread_cond_init(&watchdog->wake, &attributes);
+    pthread_condattr_destroy(&attributes);
+    pthread_mutex_init(&watchdog->lock, NULL);
+    watchdog->stop = stop;
+    watchdog->deadline = deadline;
+    watchdog->cancelled = false;
+    watchdog->started = pthread_create(&watchdog->thread, NULL, runWatchdog, watchdog) == 0;
+    return watchdog->started;
+}
+
+//Cancels a watchdog if its deadline has not passed, and waits for its thread to finish
+void stopWatchdog(Watchdog *watchdog) {
+    pthread_mutex_lock(&watchdog->lock);
+    watchdog->cancelled = true;
+    pthread_cond_signal(&watchdog->wake);
+    pthread_mutex_unlock(&watchdog->lock);
+    if (watchdog->started) {
+        pthread_join(watchdog->thread, NULL);
+    }
+    pthread_cond_destroy(&watchdog->wake);
+    pthread_mutex_destroy(&watchdog->lock);
+}
+
+/**Searches a position with negamax and alpha-beta pruning, returns the score for the colour to move
+ * A colour with no valid move passes without using up depth, and two passes in a row end the game
+ * Results are kept in the hash table, and moves are searched in the order given by scoreMoves
+ */
+int searchGameState(GameState *state, int depth, int alpha, int beta, bool passed, SearchInfo *info) {
+    
+    //Stop once the position limit is reached or another thread has stopped the search, the result is thrown away
+    info->nodes++;
+    COUNT_STAT(nodes, 1);
+    if ((info->maxNodes > 0 && info->nodes >= info->maxNodes && info->completedDepth > 0) ||
+        atomic_load_explicit(info->stop, memory_order_relaxed))
+    {
+        info->aborted = true;
+        return 0;
+    }
+    
+    if (depth == 0) {
+        return evaluateGameState(state);
+    }
+    
+    //Use a stored result if it was searched deep enough and its bound settles this search
+    int bestSquare = -1, symmetry = 0;
+    uint64_t key = findHashKey(state, &symmetry);
+    HashEntry entry;
+    if (probeHashTable(info->table, key, &entry, info)) {
+        if (entry.depth >= depth) {
+            if (entry.bound == BOUND_EXACT ||
+                (entry.bound == BOUND_LOWER && entry.score >= beta) ||
+                (entry.bound == BOUND_UPPER && entry.score <= alpha))
+            {
+                return entry.score;
+            }
+        }
+        if (entry.bestSquare >= 0) {
+            bestSquare = transformSquare(state->board.dimension, invertSymmetry(symmetry), entry.bestSquare);
+        }
+    }
+    
+    MoveList moves;
+    generateBitBoardMoves(&state->board, state->turn, &moves);
+    
+    //If there is no available move, pass, or end the game if the other colour just passed
+    if (moves.numMoves == 0) {
+        if (passed) {
+            return scoreFinishedGame(state);
+        }
+        passGameState(state);
+        int score = -searchGameState(state, depth, -beta, -alpha, true, info);
+        undoGameStateMove(state);
+        return score;
+    }
+    
+    long long moveScores[MAX_DIMENSION * MAX_DIMENSION];
+    scoreMoves(state, &moves, bestSquare, depth, info, moveScores);
+    
+    int originalAlpha = alpha;
+    int bestScore = -WIN_SCORE * 2;
+    for (int i = 0; i < moves.numMoves; i++) {
+        
+        pickNextMove(&moves, moveScores, i);
+        makeGameStateMove(state, &moves.moves[i]);
+        int score = -searchGameState(state, depth - 1, -beta, -alpha, false, info);
+        undoGameStateMove(state);
+        if (info->aborted) {
+            return 0;
+        }
+        
+        //Keep the best score, stop searching once the opponent would avoid this position
+        if (score > bestScore) {
+            bestScore = score;
+            bestSquare = moves.moves[i].row * state->board.dimension + moves.moves[i].col;
+        }
+        if (score > alpha) {
+            alpha = score;
+        }
+        if (alpha >= beta) {
+            recordCutoff(state, &moves.moves[i], i, depth, info);
+            break;
+        }
+    }
+    
+    //Store the result along with what kind of bound it is
+    int bound = BOUND_EXACT;
+    if (bestScore <= originalAlpha) {
+        bound = BOUND_UPPER;
+    }
+    else if (bestScore >= beta) {
+        bound = BOUND_LOWER;
+    }
+    if (bestSquare >= 0) {
+        bestSquare = transformSquare(state->board.dimension, symmetry, bestSquare);
+    }
+    storeHashTable(info->table, key, depth, bound, bestScore, bestSquare, info);
+    return bestScore;
+}
+
+/**Chooses a move for the colour to move with iterative deepening
+ * Each iteration searches the best move of the last one first, so an iteration cut short by the
+ * position limit still leaves a best move, returns the index of the move in the list
+ * Helper threads start one iteration deeper on odd indices and rotate the order of the other moves,
+ * so they fill the hash table with positions the main thread has not reached yet
+ */
+int searchRoot(GameState *state, const MoveList *moves, SearchInfo *info) {
+    info->rootUndoDepth = state->undoDepth;
+    for (int ply = 0; ply < MAX_PLY; ply++) {
+        info->killers[ply][0] = info->killers[ply][1] = -1;
+    }
+    
+    //Start from the moves in order of their class and the opponent's replies
+    int order[MAX_DIMENSION * MAX_DIMENSION], rotated[MAX_DIMENSION * MAX_DIMENSION];
+    long long scores[MAX_DIMENSION * MAX_DIMENSION];
+    scoreMoves(state, moves, -1, MOBILITY_ORDER_DEPTH, info, scores);
+    for (int i = 0; i < moves->numMoves; i++) {
+        int j = i;
+        while (j > 0 && scores[order[j - 1]] < scores[i]) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    int bestIndex = moves->numMoves > 0 ? order[0] : 0;
+    if (info->threadIndex > 0 && moves->numMoves > 2) {
+        for (int i = 1; i < moves->numMoves; i++) {
+            rotated[i] = order[1 + (i - 1 + info->threadIndex) % (moves->numMoves - 1)];
+        }
+        memcpy(order + 1, rotated + 1, (moves->numMoves - 1) * sizeof(int));
+    }
+    
+    info->aborted = false;
+    info->completedDepth = 0;
+    info->bestScore = 0;
+    
+    for (int depth = 1 + info->threadIndex % 2; depth <= info->maxDepth; depth++) {
+        int alpha = -WIN_SCORE * 2;
+        int iterationBest = -1;
+        
+        for (int i = 0; i < moves->numMoves; i++) {
+            makeGameStateMove(state, &moves->moves[order[i]]);
+            int score = -searchGameState(state, depth - 1, -WIN_SCORE * 2, -alpha, false, info);
+            undoGameStateMove(state);
+            if (info->aborted) {
+                break;
+            }
+            if (score > alpha) {
+                alpha = score;
+                iterationBest = order[i];
+            }
+        }
+        
+        //A cut short iteration is only trusted if it found a better move than the last one
+        if (iterationBest >= 0) {
+            bestIndex = iterationBest;
+            info->bestScore = alpha;
+        }
+        if (info->aborted) {
+            break;
+        }
+        info->completedDepth = depth;
+        if (info->iterationDeadline > 0 && getSeconds() >= info->iterationDeadline) {
+            break;
+        }
+        
+        //Search the best move first in the next iteration
+        for (int i = 0; i < moves->numMoves; i++) {
+            if (order[i] == bestIndex) {
+                order[i] = order[0];
+                order[0] = bestIndex;
+                break;
+            }
+        }
+    }
+    return bestIndex;
+}
+
+//Work given to a helper thread: its own copy of the position and its own search progress
+typedef struct {
+    GameState state;
+    const MoveList *moves;
+    SearchInfo info;
+} HelperSearch;
+
+//Runs the search of a helper thread until the main thread stops it
+void *runHelperSearch(void *argument) {
+    HelperSearch *helper = argument;
+    searchRoot(&helper->state, helper->moves, &helper->info);
+    collectThreadStats();
+    return NULL;
+}
+
+/**Chooses a move for the colour to move, searching with the number of threads given (Lazy SMP)
+ * Every thread searches the same position and shares what it learns through the search's hash table,
+ * the move played is the one found by the main thread, which stops the helpers once it is done
+ */
+int chooseSearchMove(GameState *state, const MoveList *moves, SearchInfo *info, int numThreads) {
+    atomic_bool stop = false;
+    int numHelpers = numThreads - 1;
+    HelperSearch *helpers = NULL;
+    pthread_t *helperThreads = NULL;
+    
+    info->table->generation++;
+    info->nodes = 0;
+    info->cutoffs = info->firstMoveCutoffs = info->cutoffIndexSum = 0;
+    info->stop = &stop;
+    info->threadIndex = 0;
+    
+    //Build the patterns for this dimension before any thread can need them
+    getPatternEvaluator(state->board.dimension);
+    
+    //Stop every thread at the deadline, wherever the search has got to
+    Watchdog watchdog;
+    if (info->deadline > 0) {
+        startWatchdog(&watchdog, &stop, info->deadline);
+    }
+    
+    //Start the helper threads, each with its own copy of the position
+    if (numHelpers > 0) {
+        helpers = calloc(numHelpers, sizeof(HelperSearch));
+        helperThreads = calloc(numHelpers, sizeof(pthread_t));
+    }
+    int numStarted = 0;
+    for (int i = 0; i < numHelpers && helpers != NULL && helperThreads != NULL; i++) {
+        helpers[i].state = *state;
+        helpers[i].moves = moves;
+        helpers[i].info.maxDepth = info->maxDepth;
+        helpers[i].info.stop = &stop;
+        helpers[i].info.table = info->table;
+        helpers[i].info.threadIndex = i + 1;
+        if (pthread_create(&helperThreads[i], NULL, runHelperSearch, &helpers[i]) != 0) {
+            break;
+        }
+        numStarted++;
+    }
+    
+    int bestIndex = searchRoot(state, moves, info);
+    
+    //Stop the helpers, and count their work along with the main thread's
+    atomic_store(&stop, true);
+    if (info->deadline > 0) {
+        stopWatchdog(&watchdog);
+    }
+    addHashTableStats(info->table, info);
+    for (int i = 0; i < numStarted; i++) {
+        pthread_join(helperThreads[i], NULL);
+        info->nodes += helpers[i].info.nodes;
+        info->cutoffs += helpers[i].info.cutoffs;
+        info->firstMoveCutoffs += helpers[i].info.firstMoveCutoffs;
+        info->cutoffIndexSum += helpers[i].info.cutoffIndexSum;
+        addHashTableStats(info->table, &helpers[i].info);
+    }
+    free(helpers);
+    free(helperThreads);
+    return bestIndex;
+}
+
+//Search of the position in front of the human, run on another thread while the human thinks
+typedef struct {
+    GameState state; //Copy of the game, so the search never touches the board being played on
+    MoveList moves;
+    SearchInfo info;
+    atomic_bool stop;
+    pthread_t thread;
+    int bestIndex; //Move the human is expected to make, in the list of moves
+    double start;
+} Ponder;
+
+Ponder ponder;
+
+void *runPonder(void *argument) {
+    Ponder *ponder = argument;
+    ponder->bestIndex = searchRoot(&ponder->state, &ponder->moves, &ponder->info);
+    collectThreadStats();
+    return NULL;
+}
+
+/**Starts searching the human's position on another thread, returns false if the thread could not be started
+ * Every reply is searched, the expected one most deeply, and the results go into the shared hash table, where the
+ * computer's search after the human's move finds the positions below the move that was played already searched
+ */
+bool startPonder(Ponder *ponder, const GameState *game) {
+    ponder->state = *game;
+    generateBitBoardMoves(&ponder->state.board, ponder->state.turn, &ponder->moves);
+    memset(&ponder->info, 0, sizeof(SearchInfo));
+    ponder->info.maxDepth = MAX_SEARCH_DEPTH;
+    ponder->info.table = &hashTable;
+    ponder->info.stop = &ponder->stop;
+    ponder->bestIndex = 0;
+    ponder->start = getSeconds();
+    atomic_init(&ponder->stop, false);
+    
+    //Build the patterns for this dimension before the thread can need them
+    getPatternEvaluator(ponder->state.board.dimension);
+    hashTable.generation++;
+    return pthread_create(&ponder->thread, NULL, runPonder, ponder) == 0;
+}
+
+//Stops the search of the human's position once the human has moved, and waits for its thread to finish
+void stopPonder(Ponder *ponder) {
+    atomic_store(&ponder->stop, true);
+    pthread_join(ponder->thread, NULL);
+    addHashTableStats(&hashTable, &ponder->info);
+}
+
+//Reports how far the search of the human's position got, and whether the human made the move it expected
+void reportPonder(const Ponder *ponder, const Move *played) {
+    const Move *expected = &ponder->moves.moves[ponder->bestIndex];
+    bool hit = expected->row == played->row && expected->col == played->col;
+    fprintf(stderr, "Ponder: depth %d, %lld nodes in %.2f s, expected %c%c, %s\n", ponder->info.completedDepth,
+            ponder->info.nodes, getSeconds() - ponder->start, expected->row + 'a', expected->col + 'a',
+            hit ? "hit" : "miss");
+}
+
+//Checks whether the endgame solver has been told to give up, only looking at the shared flag every so often
+bool isEndgameStopped(EndgameInfo *info) {
+    if (info->stop != NULL && !info->aborted && --info->stopCountdown <= 0) {
+        info->stopCountdown = ENDGAME_STOP_INTERVAL;
+        info->aborted = atomic_load_explicit(info->stop, memory_order_relaxed);
+    }
+    return info->aborted;
+}
+
+/**Plays out a position on an 8x8 bitboard where one unoccupied position is left, returns the final disc
+ * difference for the colour to move
+ * The colour to move places there if it can, otherwise the opposite colour does, otherwise the game is over
+ */
+int solveLastOne8(uint64_t own, uint64_t opponent, int square, EndgameInfo *info) {
+    int discDifference = countBits(own) - countBits(opponent);
+    info->nodes++;
+    
+    uint64_t flips = findFlipsBitboard8(own, opponent, square);
+    if (flips != 0) {
+        return discDifference + 2 * countBits(flips) + 1;
+    }
+    
+    flips = findFlipsBitboard8(opponent, own, square);
+    if (flips != 0) {
+        return discDifference - 2 * countBits(flips) - 1;
+    }
+    return discDifference;
+}
+
+//Solves a position on an 8x8 bitboard with two unoccupied positions left, trying each one directly
+int solveLastTwo8(uint64_t own, uint64_t opponent, int first, int second, int alpha, int beta, bool passed,
+                  EndgameInfo *info)
+{
+    int squares[2] = {first, second};
+    int bestScore = -ENDGAME_SCORE_LIMIT;
+    info->nodes++;
+    
+    for (int i = 0; i < 2; i++) {
+        uint64_t flips = findFlipsBitboard8(own, opponent, squares[i]);
+        if (flips == 0) {
+            continue;
+        }
+        
+        int score = -solveLastOne8(opponent ^ flips, own | flips | (1ULL << squares[i]), squares[1 - i], info);
+        if (score > bestScore) {
+            bestScore = score;
+            if (score >= beta) {
+                return score;
+            }
+        }
+    }
+    
+    //Pass if there was no move, the game is over if the other colour cannot move either
+    if (bestScore == -ENDGAME_SCORE_LIMIT) {
+        if (passed) {
+            return countBits(own) - countBits(opponent);
+        }
+        return -solveLastTwo8(opponent, own, first, second, -beta, -alpha, true, info);
+    }
+    return bestScore;
+}
+
+/**Solves a position on an 8x8 bitboard with three unoccupied positions left, trying each one directly
+ * A position alone in its quadrant is tried first, since the colour that fills a region last usually gains from it
+ */
+int solveLastThree8(uint64_t own, uint64_t opponent, int squares[3], int alpha, int beta, bool passed,
+                    EndgameInfo *info)
+{
+    int bestScore = -ENDGAME_SCORE_LIMIT;
+    info->nodes++;
+    
+    for (int i = 0; i < 3; i++) {
+        uint64_t flips = findFlipsBitboard8(own, opponent, squares[i]);
+        if (flips == 0) {
+            continue;
+        }
+        
+        int first = squares[i == 0 ? 1 : 0];
+        int second = squares[i == 2 ? 1 : 2];
+        int score = -solveLastTwo8(opponent ^ flips, own | flips | (1ULL << squares[i]), first, second, -beta,
+                                   -(alpha > bestScore ? alpha : bestScore), false, info);
+        if (score > bestScore) {
+            bestScore = score;
+            if (score >= beta) {
+                return score;
+            }
+        }
+    }
+    
+    if (bestScore == -ENDGAME_SCORE_LIMIT) {
+        if (passed) {
+            return countBits(own) - countBits(opponent);
+        }
+        return -solveLastThree8(opponent, own, squares, -beta, -alpha, true, info);
+    }
+    return bestScore;
+}
+
+//Quadrant of an 8x8 board holding a square, used to find the regions with an odd number of unoccupied positions
+int quadrantOf8(int square) {
+    return (square / 8 >= 4) * 2 + (square % 8 >= 4);
+}
+
+/**Solves a position on an 8x8 bitboard exactly with alpha-beta, returns the final disc difference for the colour to move
+ * With many unoccupied positions left, moves leaving the opponent the fewest replies are tried first (fastest-first),
+ * with fewer, moves into quadrants with an odd number of unoccupied positions are tried first (parity)
+ */
+int solveEndgame8(uint64_t own, uint64_t opponent, int alpha, int beta, bool passed, EndgameInfo *info) {
+    if (isEndgameStopped(info)) {
+        return 0;
+    }
+    uint64_t empty = ~(own | opponent);
+    int numEmpty = countBits(empty);
+    
+    //Hand the last few positions to the routines that try them directly
+    if (numEmpty <= 3) {
+        int squares[3] = {0}, quadrantEmpty[4] = {0};
+        for (int i = 0; i < numEmpty; i++) {
+            squares[i] = __builtin_ctzll(empty);
+            quadrantEmpty[quadrantOf8(squares[i])]++;
+            empty &= empty - 1;
+        }
+        if (numEmpty == 3) {
+            for (int i = 1; i < 3; i++) {
+                if (quadrantEmpty[quadrantOf8(squares[i])] == 1 && quadrantEmpty[quadrantOf8(squares[0])] != 1) {
+                    int square = squares[0];
+                    squares[0] = squares[i];
+                    squares[i] = square;
+                }
+            }
+            return solveLastThree8(own, opponent, squares, alpha, beta, passed, info);
+        }
+        if (numEmpty == 2) {
+            return solveLastTwo8(own, opponent, squares[0], squares[1], alpha, beta, passed, info);
+        }
+        if (numEmpty == 1) {
+            return solveLastOne8(own, opponent, squares[0], info);
+        }
+        info->nodes++;
+        return countBits(own) - countBits(opponent);
+    }
+    
+    info->nodes++;
+    uint64_t moves = findMovesBitboard8(own, opponent);
+    if (moves == 0) {
+        if (passed) {
+            return countBits(own) - countBits(opponent);
+        }
+        return -solveEndgame8(opponent, own, -beta, -alpha, true, info);
+    }
+    
+    //Find which quadrants have an odd number of unoccupied positions
+    int oddQuadrants = 0;
+    for (uint64_t bits = empty; bits != 0; bits &= bits - 1) {
+        oddQuadrants ^= 1 << quadrantOf8(__builtin_ctzll(bits));
+    }
+    
+    //Give each move a key, lowest first: the opponent's replies if ordering fastest-first, then parity
+    int squares[64], keys[64], numMoves = 0;
+    uint64_t flips[64];
+    for (; moves != 0; moves &= moves - 1) {
+        int square = __builtin_ctzll(moves);
+        uint64_t moveFlips = findFlipsBitboard8(own, opponent, square);
+        int key = (oddQuadrants >> quadrantOf8(square) & 1) ? 0 : 1;
+        if (numEmpty > FASTEST_FIRST_EMPTIES) {
+            key += 2 * countBits(findMovesBitboard8(opponent ^ moveFlips, own | moveFlips | (1ULL << square)));
+        }
+        
+        //Insert the move in order of its key
+        int i = numMoves++;
+        while (i > 0 && keys[i - 1] > key) {
+            squares[i] = squares[i - 1];
+            keys[i] = keys[i - 1];
+            flips[i] = flips[i - 1];
+            i--;
+        }
+        squares[i] = square;
+        keys[i] = key;
+        flips[i] = moveFlips;
+    }
+    
+    int bestScore = -ENDGAME_SCORE_LIMIT;
+    for (int i = 0; i < numMoves; i++) {
+        int score = -solveEndgame8(opponent ^ flips[i], own | flips[i] | (1ULL << squares[i]), -beta, -alpha, false, info);
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+    return bestScore;
+}
+
+/**Solves a position on a board of any dimension exactly with alpha-beta, returns the final disc difference for the
+ * colour to move, ordering moves the same way as the 8x8 solver
+ */
+int solveGameState(GameState *state, int alpha, int beta, bool passed, EndgameInfo *info) {
+    if (isEndgameStopped(info)) {
+        return 0;
+    }
+    int boardDimension = state->board.dimension;
+    int numEmpty = boardDimension * boardDimension - state->numDiscs[0] - state->numDiscs[1];
+    int own = colourIndex(state->turn);
+    int discDifference = state->numDiscs[own] - state->numDiscs[1 - own];
+    info->nodes++;
+    
+    //With one unoccupied position left, count the flips each colour would make there instead of making the move
+    if (numEmpty == 1) {
+        BitSet empty;
+        Move move;
+        findEmptyBitSet(&state->board, &empty);
+        int square = 0;
+        while (!bitSetContains(&empty, square)) {
+            square++;
+        }
+        
+        buildMove(&state->board, square / boardDimension, square % boardDimension, state->turn, &move);
+        if (move.totalFlips > 0) {
+            return discDifference + 2 * move.totalFlips + 1;
+        }
+        buildMove(&state->board, square / boardDimension, square % boardDimension, oppositeOf(state->turn), &move);
+        if (move.totalFlips > 0) {
+            return discDifference - 2 * move.totalFlips - 1;
+        }
+        return discDifference;
+    }
+    
+    MoveList moves;
+    generateBitBoardMoves(&state->board, state->turn, &moves);
+    if (moves.numMoves == 0) {
+        if (passed || numEmpty == 0) {
+            return discDifference;
+        }
+        passGameState(state);
+        int score = -solveGameState(state, -beta, -alpha, true, info);
+        undoGameStateMove(state);
+        return score;
+    }
+    
+    //Find which quadrants have an odd number of unoccupied positions
+    BitSet empty;
+    int half = boardDimension / 2, oddQuadrants = 0;
+    findEmptyBitSet(&state->board, &empty);
+    for (int i = 0; i < state->board.numWords; i++) {
+        for (uint64_t word = empty.words[i]; word != 0; word &= word - 1) {
+            int square = i * 64 + __builtin_ctzll(word);
+            oddQuadrants ^= 1 << ((square / boardDimension >= half) * 2 + (square % boardDimension >= half));
+        }
+    }
+    
+    //Order the moves by key, lowest first: the opponent's replies if ordering fastest-first, then parity
+    int keys[MAX_DIMENSION * MAX_DIMENSION];
+    for (int i = 0; i < moves.numMoves; i++) {
+        Move move = moves.moves[i];
+        int key = (oddQuadrants >> ((move.row >= half) * 2 + (move.col >= half)) & 1) ? 0 : 1;
+        if (numEmpty > FASTEST_FIRST_EMPTIES) {
+            makeGameStateMove(state, &move);
+            key += 2 * countBitBoardMoves(&state->board, state->turn);
+            undoGameStateMove(state);
+        }
+        
+        int j = i;
+        while (j > 0 && keys[j - 1] > key) {
+            moves.moves[j] = moves.moves[j - 1];
+            keys[j] = keys[j - 1];
+            j--;
+        }
+        moves.moves[j] = move;
+        keys[j] = key;
+    }
+    
+    int bestScore = -ENDGAME_SCORE_LIMIT;
+    for (int i = 0; i < moves.numMoves; i++) {
+        makeGameStateMove(state, &moves.moves[i]);
+        int score = -solveGameState(state, -beta, -alpha, false, info);
+        undoGameStateMove(state);
+        if (score > bestScore) {
+            bestScore = score;
+            if (score > alpha) {
+                alpha = score;
+                if (alpha >= beta) {
+                    break;
+                }
+            }
+        }
+    }
+    return bestScore;
+}
+
+/**Solves the position for the colour to move and returns the index of a best move in the list
+ * The final disc difference with perfect play is left in the info, or only its sign if solving for win, loss or draw
+ * If the stop flag is set first, the solver gives up and sets aborted, and only the moves already solved are compared
+ */
+int solveEndgame(GameState *state, const MoveList *moves, EndgameInfo *info) {
+    int alpha = info->winLossDraw ? -1 : -ENDGAME_SCORE_LIMIT;
+    int beta = info->winLossDraw ? 1 : ENDGAME_SCORE_LIMIT;
+    int bestIndex = 0;
+    info->score = -ENDGAME_SCORE_LIMIT;
+    
+    for (int i = 0; i < moves->numMoves && alpha < beta; i++) {
+        int score = 0;
+        
+        //Standard 8x8 boards fit in a single word
+        if (state->board.dimension == 8) {
+            const Move *move = &moves->moves[i];
+            uint64_t own = getColourBitSet(&state->board, state->turn)->words[0];
+            uint64_t opponent = getOppositeBitSet(&state->board, state->turn)->words[0];
+            int square = move->row * 8 + move->col;
+            uint64_t flips = findFlipsBitboard8(own, opponent, square);
+            score = -solveEndgame8(opponent ^ flips, own | flips | (1ULL << square), -beta, -alpha, false, info);
+        }
+        else {
+            makeGameStateMove(state, &moves->moves[i]);
+            score = -solveGameState(state, -beta, -alpha, false, info);
+            undoGameStateMove(state);
+        }
+        if (info->aborted) {
+            break;
+        }
+        
+        if (score > info->score) {
+            info->score = score;
+            bestIndex = i;
+            if (score > alpha) {
+                alpha = score;
+            }
+        }
+    }
+    
+    if (info->winLossDraw) {
+        info->score = info->score > 0 ? 1 : info->score < 0 ? -1 : 0;
+    }
+    COUNT_STAT(endgameNodes, info->nodes);
+    return bestIndex;
+}
+
+//Allocates an arena for Monte Carlo search trees, returns false if there is not enough memory
+bool createMctsArena(MctsArena *arena, int megabytes) {
+    long long capacity = (long long) megabytes * 1024 * 1024 / sizeof(MctsNode);
+    arena->capacity = capacity < INT32_MAX ? (int) capacity : INT32_MAX;
+    arena->nodes = arena->capacity > 0 ? malloc((size_t) arena->capacity * sizeof(MctsNode)) : NULL;
+    arena->peak = 0;
+    atomic_init(&arena->used, 0);
+    return arena->nodes != NULL;
+}
+
+//Takes a block of nodes next to each other from the arena, returns the index of the first or -1 if the arena is full
+int allocateMctsNodes(MctsArena *arena, int count) {
+    int first = atomic_load(&arena->used);
+    do {
+        if (first > arena->capacity - count) {
+            return -1;
+        }
+    } while (!atomic_compare_exchange_weak(&arena->used, &first, first + count));
+    return first;
+}
+
+void initMctsNode(MctsNode *node, int square) {
+    node->square = square;
+    node->firstChild = 0;
+    node->numChildren = 0;
+    atomic_init(&node->state, MCTS_UNEXPANDED);
+    atomic_init(&node->visits, 0);
+    atomic_init(&node->virtualLosses, 0);
+    atomic_init(&node->score, 0);
+}
+
+/**Gives a node a child for each valid move of the colour to move, a single pass child if only the opponent can move,
+ * or no children if the game is over
+ * Returns false, leaving the node a leaf, if another thread is already expanding it or the arena is full,
+ * in which case the node stays claimed so no later playout tries again before the arena is reset
+ */
+bool expandMctsNode(MctsArena *arena, MctsNode *node, BitBoard *bitBoard, char turn) {
+    int expected = MCTS_UNEXPANDED;
+    if (!atomic_compare_exchange_strong(&node->state, &expected, MCTS_EXPANDING)) {
+        return false;
+    }
+    
+    BitSet moves;
+    findBitBoardMoves(bitBoard, turn, &moves);
+    int numChildren = countBitSet(&moves, bitBoard->numWords);
+    bool pass = numChildren == 0 && countBitBoardMoves(bitBoard, oppositeOf(turn)) > 0;
+    int first = allocateMctsNodes(arena, pass ? 1 : numChildren);
+    if (first < 0) {
+        return false;
+    }
+    
+    if (pass) {
+        initMctsNode(&arena->nodes[first], -1);
+        numChildren = 1;
+    }
+    else {
+        int child = first;
+        for (int word = 0; word < bitBoard->numWords; word++) {
+            for (uint64_t bits = moves.words[word]; bits != 0; bits &= bits - 1) {
+                initMctsNode(&arena->nodes[child++], word * 64 + __builtin_ctzll(bits));
+            }
+        }
+    }
+    node->firstChild = first;
+    node->numChildren = numChildren;
+    atomic_store(&node->state, MCTS_EXPANDED);
+    return true;
+}
+
+/**Selects the child of an expanded node with the best upper confidence bound, returns its arena index
+ * A child no playout has reached yet is always selected first, and unfinished playouts count as losses
+ * so threads spread out over the tree
+ */
+int selectMctsChild(MctsArena *arena, MctsNode *node, double exploration) {
+    double logVisits = log(atomic_load(&node->visits) + atomic_load(&node->virtualLosses) + 1);
+    int bestIndex = node->firstChild;
+    double bestValue = -1;
+    
+    for (int i = node->firstChild; i < node->firstChild + node->numChildren; i++) {
+        MctsNode *child = &arena->nodes[i];
+        int visits = atomic_load(&child->visits) + atomic_load(&child->virtualLosses);
+        if (visits == 0) {
+            return i;
+        }
+        double value = atomic_load(&child->score) / (2.0 * visits) + exploration * sqrt(logVisits / visits);
+        if (value > bestValue) {
+            bestValue = value;
+            bestIndex = i;
+        }
+    }
+    return bestIndex;
+}
+
+/**Plays random moves from a position until the game is over, returns the final disc difference for Black
+ * Unoccupied positions are tried in a random order and the first valid one is played, which picks uniformly
+ * among the valid moves without generating all of them
+ */
+int playOutMcts(BitBoard *bitBoard, char turn, uint64_t *random) {
+    int boardDimension = bitBoard->dimension;
+    int empties[MAX_DIMENSION * MAX_DIMENSION];
+    int numEmpty = 0;
+    BitSet empty;
+    findEmptyBitSet(bitBoard, &empty);
+    for (int word = 0; word < bitBoard->numWords; word++) {
+        for (uint64_t bits = empty.words[word]; bits != 0; bits &= bits - 1) {
+            empties[numEmpty++] = word * 64 + __builtin_ctzll(bits);
+        }
+    }
+    
+    //The game is over once both colours pass in a row
+    Move move;
+    int passes = 0;
+    while (numEmpty > 0 && passes < 2) {
+        int tried = 0;
+        for (; tried < numEmpty; tried++) {
+            int pick = tried + nextRandom(random) % (numEmpty - tried);
+            int square = empties[pick];
+            empties[pick] = empties[tried];
+            empties[tried] = square;
+            buildMove(bitBoard, square / boardDimension, square % boardDimension, turn, &move);
+            if (move.totalFlips > 0) {
+                break;
+            }
+        }
+        
+        if (tried < numEmpty) {
+            applyBitBoardMove(bitBoard, &move, turn);
+            empties[tried] = empties[--numEmpty];
+            passes = 0;
+        }
+        else {
+            passes++;
+        }
+        turn = oppositeOf(turn);
+    }
+    return countBitSet(&bitBoard->black, bitBoard->numWords) - countBitSet(&bitBoard->white, bitBoard->numWords);
+}
+
+/**Runs one playout: selects a path down the tree, expands the leaf it ends at if a playout has reached it before,
+ * plays the rest of the game randomly, and adds the result to every node on the path
+ */
+void runMctsPlayout(MctsSearch *search, uint64_t *random) {
+    MctsArena *arena = search->arena;
+    BitBoard bitBoard = search->root;
+    int boardDimension = bitBoard.dimension;
+    char turn = search->turn;
+    MctsNode *path[MAX_UNDO + 1];
+    char movers[MAX_UNDO + 1]; //Colour that moved into each node on the path
+    int length = 0;
+    Move move;
+    
+    MctsNode *node = &arena->nodes[0];
+    movers[length] = 0;
+    path[length++] = node;
+    while (true) {
+        if (atomic_load(&node->state) != MCTS_EXPANDED &&
+            (atomic_load(&node->visits) == 0 || !expandMctsNode(arena, node, &bitBoard, turn)))
+        {
+            break;
+        }
+        if (node->numChildren == 0) {
+            break;
+        }
+        
+        node = &arena->nodes[selectMctsChild(arena, node, search->exploration)];
+        atomic_fetch_add(&node->virtualLosses, 1);
+        if (node->square >= 0) {
+            buildMove(&bitBoard, node->square / boardDimension, node->square % boardDimension, turn, &move);
+            applyBitBoardMove(&bitBoard, &move, turn);
+        }
+        movers[length] = turn;
+        path[length++] = node;
+        turn = oppositeOf(turn);
+    }
+    
+    int margin = playOutMcts(&bitBoard, turn, random);
+    int blackScore = margin > 0 ? 2 : margin == 0 ? 1 : 0;
+    for (int i = 0; i < length; i++) {
+        atomic_fetch_add(&path[i]->visits, 1);
+        if (i > 0) {
+            atomic_fetch_add(&path[i]->score, movers[i] == 'B' ? blackScore : 2 - blackScore);
+            atomic_fetch_sub(&path[i]->virtualLosses, 1);
+        }
+    }
+}
+
+//One thread of a Monte Carlo tree search, with its own random playouts
+typedef struct {
+    MctsSearch *search;
+    uint64_t random;
+    long long completed;
+} MctsWorker;
+
+//Runs playouts until the search's playout limit or time is used up
+void *runMctsWorker(void *argument) {
+    MctsWorker *worker = argument;
+    MctsSearch *search = worker->search;
+    
+    while (true) {
+        long long playout = atomic_fetch_add(&search->playouts, 1);
+        if ((search->maxPlayouts > 0 && playout >= search->maxPlayouts) ||
+            (search->deadline > 0 && getSeconds() >= search->deadline))
+        {
+            break;
+        }
+        runMctsPlayout(search, &worker->random);
+        worker->completed++;
+        COUNT_STAT(playouts, 1);
+    }
+    collectThreadStats();
+    return NULL;
+}
+
+/**Chooses a move with a Monte Carlo tree search, returns the index of the move in the list
+ * The arena is reset and the tree for this move is built in it by every thread at once,
+ * then the move whose node was visited most is chosen
+ */
+int chooseMctsMove(GameState *state, const MoveList *moves, MctsSearch *search, int numThreads) {
+    MctsArena *arena = search->arena;
+    int boardDimension = state->board.dimension;
+    search->root = state->board;
+    search->turn = state->turn;
+    search->completed = 0;
+    search->bestVisits = 0;
+    search->bestScore = 0;
+    atomic_init(&search->playouts, 0);
+    
+    //The root is expanded before the threads start, so its children are the valid moves
+    atomic_store(&arena->used, 0);
+    if (allocateMctsNodes(arena, 1) < 0) {
+        return 0;
+    }
+    MctsNode *root = &arena->nodes[0];
+    initMctsNode(root, -1);
+    if (!expandMctsNode(arena, root, &search->root, search->turn)) {
+        return 0;
+    }
+    
+    //Helper threads search the same tree, the calling thread is the first worker
+    MctsWorker *workers = calloc(numThreads, sizeof(MctsWorker));
+    pthread_t *threads = calloc(numThreads, sizeof(pthread_t));
+    MctsWorker mainWorker = {0};
+    if (workers == NULL || threads == NULL) {
+        numThreads = 1;
+    }
+    for (int i = 0; i < numThreads; i++) {
+        MctsWorker *worker = workers != NULL ? &workers[i] : &mainWorker;
+        uint64_t seed = search->seed + i;
+        worker->search = search;
+        worker->random = nextRandom(&seed);
+    }
+    int numStarted = 1;
+    for (int i = 1; i < numThreads; i++) {
+        if (pthread_create(&threads[i], NULL, runMctsWorker, &workers[i]) != 0) {
+            break;
+        }
+        numStarted++;
+    }
+    runMctsWorker(workers != NULL ? &workers[0] : &mainWorker);
+    search->completed = workers != NULL ? workers[0].completed : mainWorker.completed;
+    for (int i = 1; i < numStarted; i++) {
+        pthread_join(threads[i], NULL);
+        search->completed += workers[i].completed;
+    }
+    free(workers);
+    free(threads);
+    
+    int used = atomic_load(&arena->used);
+    if (used > arena->peak) {
+        arena->peak = used;
+    }
+    
+    //Play the move explored most, the most reliable estimate
+    const MctsNode *best = &arena->nodes[root->firstChild];
+    for (int i = root->firstChild; i < root->firstChild + root->numChildren; i++) {
+        if (atomic_load(&arena->nodes[i].visits) > atomic_load(&best->visits)) {
+            best = &arena->nodes[i];
+        }
+    }
+    search->bestVisits = atomic_load(&best->visits);
+    search->bestScore = atomic_load(&best->score);
+    const Move *bestMove = findMove(moves, best->square / boardDimension, best->square % boardDimension);
+    return bestMove != NULL ? bestMove - moves->moves : 0;
+}
+
+//Identifies an opening book file, stored in the first bytes of its header
+#define BOOK_FILE_MAGIC "OTHBOK2"
+
+/**Header at the start of an opening book file, followed by numEntries entries sorted by hash
+ * The second version keys entries by the hash of each position's canonical form instead of the position itself
+ * Fields are in host byte order
+ */
+typedef struct {
+    char magic[8];
+    uint32_t dimension;
+    uint32_t entrySize;
+    uint64_t numEntries;
+} BookFileHeader;
+
+//Best move found for a position in the opening, keyed by the Zobrist hash of the position's canonical form
+typedef struct {
+    uint64_t hash;
+    int32_t score; //Score of the search for the colour to move
+    int16_t bestSquare; //Best move as (row * boardDimension + col), on the canonical form
+    int16_t depth; //Depth the search completed
+} BookEntry;
+
+//Opening book mapped into memory for reading
+typedef struct {
+    int fd;
+    void *data;
+    size_t mappedSize;
+    int dimension;
+    const BookEntry *entries;
+    uint64_t numEntries;
+} OpeningBook;
+
+OpeningBook openingBook;
+
+//Maps an opening book for reading, returns false if it cannot be opened or is not an opening book
+bool openOpeningBook(const char *fileName, OpeningBook *book) {
+    memset(book, 0, sizeof(OpeningBook));
+    book->fd = open(fileName, O_RDONLY);
+    if (book->fd < 0) {
+        return false;
+    }
+    
+    struct stat status;
+    BookFileHeader header;
+    if (fstat(book->fd, &status) != 0 || (size_t) status.st_size < sizeof(header)) {
+        close(book->fd);
+        return false;
+    }
+    book->mappedSize = status.st_size;
+    book->data = mmap(NULL, book->mappedSize, PROT_READ, MAP_PRIVATE, book->fd, 0);
+    if (book->data == MAP_FAILED) {
+        book->data = NULL;
+        close(book->fd);
+        return false;
+    }
+    
+    //Check the header describes entries that fit in the file
+    memcpy(&header, book->data, sizeof(header));
+    if (memcmp(header.magic, BOOK_FILE_MAGIC, sizeof(header.magic)) != 0
+        || header.dimension < 4 || header.dimension > MAX_DIMENSION || header.entrySize != sizeof(BookEntry)
+        || header.numEntries > (book->mappedSize - sizeof(header)) / sizeof(BookEntry))
+    {
+        munmap(book->data, book->mappedSize);
+        close(book->fd);
+        book->data = NULL;
+        return false;
+    }
+    book->dimension = header.dimension;
+    book->entries = (const BookEntry *) ((const char *) book->data + sizeof(header));
+    book->numEntries = header.numEntries;
+    return true;
+}
+
+//Unmaps an opening book
+void closeOpeningBook(OpeningBook *book) {
+    if (book->data != NULL) {
+        munmap(book->data, book->mappedSize);
+        close(book->fd);
+    }
+    memset(book, 0, sizeof(OpeningBook));
+}
+
+/**Looks up a hash in an opening book, returns false if it is not there
+ * Zobrist hashes are spread evenly, so the search guesses where the hash falls between the ends of the range
+ * (interpolation search), switching to halving the range if the guesses do not close in quickly
+ */
+bool findBookEntry(const OpeningBook *book, uint64_t hash, BookEntry *entry) {
+    if (book->numEntries == 0) {
+        return false;
+    }
+    
+    uint64_t low = 0, high = book->numEntries - 1;
+    int guesses = 0;
+    while (low <= high && hash >= book->entries[low].hash && hash <= book->entries[high].hash) {
+        uint64_t lowHash = book->entries[low].hash, highHash = book->entries[high].hash;
+        uint64_t middle = low + (high - low) / 2;
+        if (guesses < 8 && highHash > lowHash) {
+            middle = low + (uint64_t) ((unsigned __int128) (hash - lowHash) * (high - low) / (highHash - lowHash));
+            guesses++;
+        }
+        
+        if (book->entries[middle].hash == hash) {
+            *entry = book->entries[middle];
+            return true;
+        }
+        if (book->entries[middle].hash < hash) {
+            low = middle + 1;
+        }
+        else if (middle == 0) {
+            break;
+        }
+        else {
+            high = middle - 1;
+        }
+    }
+    return false;
+}
+
+/**Looks up a position in an opening book by its canonical form, returns false if it is not there
+ * The entry's best move is mapped back from the canonical form onto the position
+ */
+bool probeOpeningBook(const OpeningBook *book, const GameState *state, BookEntry *entry) {
+    int symmetry = 0;
+    if (book->numEntries == 0 || !findBookEntry(book, computeCanonicalHash(state, &symmetry), entry)) {
+        return false;
+    }
+    entry->bestSquare = transformSquare(state->board.dimension, invertSymmetry(symmetry), entry->bestSquare);
+    return true;
+}
+
+/**Attempts to make move specified by user
+ * The move is checked against the tracked valid moves, then made on the board, the game state and the tracker
+ */
+bool makeMove(char board[][26], int boardDimension, char player, GameState *game, MoveTracker *tracker) {
+    
+    //Get move from player
+    char rowChar = '0', colChar = '0';
+    printf("Enter move for colour %c (RowCol): ", player);
+    scanf(" %c%c", &rowChar, &colChar);
+    
+    //Convert row and column into integer indices
+    int row = rowChar - 'a';
+    int col = colChar - 'a';
+    
+    //If position is not one of the player's valid moves, move is invalid
+    if (!positionInBounds(boardDimension, row, col) ||
+        !bitSetContains(&tracker->valid[colourIndex(player)], row * boardDimension + col))
+    {
+        return false;
+    }
+    
+    //Make the flips and place player's chip at chosen position
+    Move move;
+    buildMove(&game->board, row, col, player, &move);
+    applyMove(board, &move, player);
+    makeGameStateMove(game, &move);
+    updateMoveTracker(game, tracker, &move);
+    
+    return true;
+}
+
+//Checks to see if a specified position is valid for a move
+bool checkValidPosition(int row, int col, char colour, char board[][26], int boardDimension) {
+    
+    //If there is a move to be made in any of the 8 directions, return true
+    //This is represented by the walk along the ray in that direction finding tiles to flip
+    const unsigned char *lengths = (*getRayLengths(boardDimension))[row][col];
+    const char *start = (const char *) board + row * BOARD_ROW_STRIDE + col;
+    char opponent = colour == 'W' ? 'B' : 'W';
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        if (walkRay(start, lengths[direction], RAY_STEP[direction], colour, opponent) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+//Evaluates and scores a potential move for the computer to make
+int evaluatePosition(int row, int col, char colour, char board[][26], int boardDimension) {
+    int score = 0;
+    
+    //Search in all eight directions, along rays that stop at the edge of the board
+    const unsigned char *lengths = (*getRayLengths(boardDimension))[row][col];
+    const char *start = (const char *) board + row * BOARD_ROW_STRIDE + col;
+    char opponent = colour == 'W' ? 'B' : 'W';
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        score += walkRay(start, lengths[direction], RAY_STEP[direction], colour, opponent);
+    }
+    
+    return score;
+}
+
+//Count number of valid positions
+int countValidPositions(char board[][26], int boardDimension, char colour) {
+    
+    //Standard 8x8 boards find every valid position at once on bitboards
+    if (boardDimension == 8) {
+        uint64_t own = 0, opponent = 0;
+        loadBitboard8(board, colour, &own, &opponent);
+        return countBits(findMovesBitboard8(own, opponent));
+    }
+    
+    //Other boards find every valid position at once on a bit board
+    BitBoard bitBoard;
+    loadBitBoard(board, boardDimension, &bitBoard);
+    return countBitBoardMoves(&bitBoard, colour);
+}
+
+/**Works out how many seconds the computer may take for its next move, 0 for no limit
+ * With a clock, the time left is shared out over the moves the computer still has to make, about half of the
+ * unoccupied positions, plus its increment, but one move never takes more than a fixed share of the clock
+ * A margin is kept back for the work around the search, and a move time caps the budget either way
+ */
+double allocateMoveTime(int numEmpty) {
+    double budget = 0;
+    if (computerSettings.clockSeconds > 0) {
+        int movesLeft = (numEmpty + 1) / 2;
+        budget = computerClock / (movesLeft > 0 ? movesLeft : 1) + computerSettings.incrementSeconds;
+        if (budget > computerClock * MAX_CLOCK_SHARE) {
+            budget = computerClock * MAX_CLOCK_SHARE;
+        }
+    }
+    if (computerSettings.moveMilliseconds > 0 && (budget <= 0 || budget > computerSettings.moveMilliseconds / 1000.0)) {
+        budget = computerSettings.moveMilliseconds / 1000.0;
+    }
+    if (computerSettings.clockSeconds > 0 || computerSettings.moveMilliseconds > 0) {
+        budget = budget > 2 * MOVE_TIME_MARGIN ? (budget - MOVE_TIME_MARGIN) * (1 - MOVE_TIME_SAFETY) : MOVE_TIME_MARGIN / 2;
+    }
+    return budget;
+}
+
+/**Makes the best move for the computer
+ * The computer chooses from the tracked valid moves, then makes its move on the board, the game state and the tracker
+ */
+void makeComputerMove(char board[][26], int boardDimension, char computer, GameState *game, MoveTracker *tracker) {
+#ifdef OTHELLO_STATS
+    Stats startStats;
+    double startCpu = 0;
+    if (computerSettings.statsMode == STATS_MOVES) {
+        snapshotStats(&startStats, &startCpu);
+    }
+#endif
+    MoveList computerMoves;
+    generateTrackedMoves(game, tracker, computer, &computerMoves);
+    const Move *bestMove = &computerMoves.moves[0];
+    
+    //Play from the opening book if it has the position
+    BookEntry entry;
+    const Move *bookMove = NULL;
+    double bookStart = getSeconds();
+    if (probeOpeningBook(&openingBook, game, &entry)) {
+        bookMove = findMove(&computerMoves, entry.bestSquare / boardDimension, entry.bestSquare % boardDimension);
+    }
+    
+    //Share out the computer's time if it plays against the clock or has a time for each move
+    int numEmpty = boardDimension * boardDimension - game->numDiscs[0] - game->numDiscs[1];
+    double moveStart = getSeconds();
+    double budget = allocateMoveTime(numEmpty);
+    bool decided = false;
+    if (bookMove != NULL) {
+        bestMove = bookMove;
+        decided = true;
+        if (computerSettings.verbose) {
+            fprintf(stderr, "Book: score %d, depth %d, %.1f microseconds\n", entry.score, entry.depth,
+                    (getSeconds() - bookStart) * 1e6);
+        }
+    }
+    
+    /**Solve the rest of the game exactly once few enough positions are unoccupied
+     * Against the clock the solver gets part of the budget, and if it gives up the search uses the rest
+     */
+    if (!decided && numEmpty <= computerSettings.endgameEmpties) {
+        EndgameInfo endgame = {0};
+        endgame.winLossDraw = computerSettings.endgameWinLossDraw;
+        atomic_bool stop = false;
+        Watchdog watchdog;
+        if (budget > 0) {
+            endgame.stop = &stop;
+            startWatchdog(&watchdog, &stop, moveStart + budget * ENDGAME_TIME_SHARE);
+        }
+        double start = getSeconds();
+        int index = solveEndgame(game, &computerMoves, &endgame);
+        double seconds = getSeconds() - start;
+        if (budget > 0) {
+            stopWatchdog(&watchdog);
+        }
+        if (!endgame.aborted) {
+            bestMove = &computerMoves.moves[index];
+            decided = true;
+        }
+        
+        if (computerSettings.verbose && endgame.aborted) {
+            fprintf(stderr, "Endgame: %d empties, gave up after %lld nodes\n", numEmpty, endgame.nodes);
+        }
+        else if (computerSettings.verbose) {
+            fprintf(stderr, "Endgame: %d empties, score %d, %lld nodes, %.0f nodes per second\n", numEmpty,
+                    endgame.score, endgame.nodes, seconds > 0 ? endgame.nodes / seconds : 0.0);
+        }
+    }
+    
+    //Build a Monte Carlo search tree if the computer has been given a playout or time budget
+    if (!decided && mctsArena.nodes != NULL) {
+        MctsSearch search = {0};
+        search.arena = &mctsArena;
+        search.exploration = computerSettings.mctsExploration;
+        search.maxPlayouts = computerSettings.mctsPlayouts;
+        search.seed = game->hash;
+        double start = getSeconds();
+        if (computerSettings.mctsMilliseconds > 0) {
+            search.deadline = start + computerSettings.mctsMilliseconds / 1000.0;
+        }
+        if (budget > 0 && (search.deadline == 0 || search.deadline > moveStart + budget)) {
+            search.deadline = moveStart + budget;
+        }
+        bestMove = &computerMoves.moves[chooseMctsMove(game, &computerMoves, &search, computerSettings.threads)];
+        double seconds = getSeconds() - start;
+        
+        if (computerSettings.verbose) {
+            fprintf(stderr, "MCTS: %lld playouts, %.0f playouts per second, win rate %.1f%%, tree %.1f MB\n",
+                    search.completed, seconds > 0 ? search.completed / seconds : 0.0,
+                    search.bestVisits > 0 ? 50.0 * search.bestScore / search.bestVisits : 0.0,
+                    atomic_load(&mctsArena.used) * sizeof(MctsNode) / (1024.0 * 1024.0));
+        }
+    }
+    
+    /**Search ahead if the computer has been given a search depth or a time limit
+     * Against the clock the search deepens until its deadline, always keeping the best move of the last iteration
+     */
+    else if (!decided && (computerSettings.searchDepth > 0 || budget > 0)) {
+        SearchInfo info = {0};
+        info.maxDepth = computerSettings.searchDepth > 0 ? computerSettings.searchDepth : MAX_SEARCH_DEPTH;
+        info.maxNodes = computerSettings.searchNodes;
+        info.table = &hashTable;
+        if (budget > 0) {
+            info.deadline = moveStart + budget;
+            info.iterationDeadline = moveStart + budget * ITERATION_TIME_SHARE;
+        }
+        bestMove = &computerMoves.moves[chooseSearchMove(game, &computerMoves, &info, computerSettings.threads)];
+        
+        if (computerSettings.verbose) {
+            long long cutoffs = info.cutoffs > 0 ? info.cutoffs : 1;
+            fprintf(stderr, "Search: depth %d, score %d, %lld nodes, %.1f%% first-move cutoffs, average cutoff index %.2f\n",
+                    info.completedDepth, info.bestScore, info.nodes, 100.0 * info.firstMoveCutoffs / cutoffs,
+                    (double) info.cutoffIndexSum / cutoffs);
+        }
+    }
+    
+    //Otherwise iterate through the valid moves in the same order as the board, keeping the first one with the most flips
+    else if (!decided) {
+        for (int i = 1; i < computerMoves.numMoves; i++) {
+            if (computerMoves.moves[i].totalFlips > bestMove->totalFlips) {
+                bestMove = &computerMoves.moves[i];
+            }
+        }
+    }
+    
+    //Make the flips and place computer's chip at chosen position
+    applyMove(board, bestMove, computer);
+    makeGameStateMove(game, bestMove);
+    updateMoveTracker(game, tracker, bestMove);
+    
+    //Take the time used off the clock
+    double moveSeconds = getSeconds() - moveStart;
+    if (computerSettings.clockSeconds > 0) {
+        computerClock += computerSettings.incrementSeconds - moveSeconds;
+    }
+    if (computerSettings.verbose && budget > 0) {
+        fprintf(stderr, "Time: %.1f ms of a %.1f ms budget", moveSeconds * 1000, budget * 1000);
+        if (computerSettings.clockSeconds > 0) {
+            fprintf(stderr, ", %.2f s left on the clock", computerClock);
+        }
+        fprintf(stderr, "\n");
+    }
+#ifdef OTHELLO_STATS
+    if (computerSettings.statsMode == STATS_MOVES) {
+        Stats endStats;
+        double endCpu = 0;
+        snapshotStats(&endStats, &endCpu);
+        printStatsJson("move", game->undoDepth, &startStats, &endStats, moveSeconds, endCpu - startCpu);
+    }
+#endif
+    
+    //Output computer's move
+    char rowChar = bestMove->row + 'a';
+    char colChar = bestMove->col + 'a';
+    printf("Computer places %c at %c%c.\n", computer, rowChar, colChar);
+}
+
+//Checks to see if the game is over, using the valid moves kept by the tracker
+bool isGameOver(const GameState *game, const MoveTracker *tracker) {
+    
+    //If there are no valid moves for both player and computer, game is over
+    if (tracker->numValid[0] + tracker->numValid[1] == 0) {
+        return true;
+    }
+    
+    //If the board is full, game is over
+    if (isBitBoardFull(&game->board)) {
+        return true;
+    }
+    
+    return false;
+}
+
+//Identifies a binary position file, stored in the first bytes of its header
+#define POSITION_FILE_MAGIC "OTHPOS1"
+
+//Marks a position record that has no move to check
+#define NO_POSITION_MOVE 0xFF
+
+/**Header at the start of a binary position file, followed by numPositions records of recordSize bytes
+ * Each record holds the colour to move (or of the move to check), then the move's row and col (NO_POSITION_MOVE if
+ * there is none, the dimension if it is off the board), then five zero bytes, then one bit per position for Black
+ * and then for White, bit (row * dimension + col) in 64-bit words of host byte order
+ */
+typedef struct {
+    char magic[8];
+    uint32_t dimension;
+    uint32_t recordSize;
+    uint64_t numPositions;
+} PositionFileHeader;
+
+//Binary position file mapped into memory, either read-only or being written
+typedef struct {
+    int fd;
+    bool writable;
+    unsigned char *data;
+    size_t mappedSize;
+    int dimension;
+    int numWords; //Words in each colour's set of positions
+    size_t recordSize;
+    uint64_t numPositions;
+    uint64_t capacity; //Records the mapping has room for while writing
+} PositionFile;
+
+//Maps a binary position file for reading, returns false if it cannot be opened or is not a valid position file
+bool openPositionFile(const char *fileName, PositionFile *file) {
+    memset(file, 0, sizeof(PositionFile));
+    file->fd = open(fileName, O_RDONLY);
+    if (file->fd < 0) {
+        return false;
+    }
+    
+    struct stat status;
+    PositionFileHeader header;
+    if (fstat(file->fd, &status) != 0 || (size_t)status.st_size < sizeof(header)) {
+        close(file->fd);
+        return false;
+    }
+    file->mappedSize = status.st_size;
+    file->data = mmap(NULL, file->mappedSize, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (file->data == MAP_FAILED) {
+        close(file->fd);
+        return false;
+    }
+    
+    //Check the header describes records that fit in the file
+    memcpy(&header, file->data, sizeof(header));
+    bool valid = memcmp(header.magic, POSITION_FILE_MAGIC, sizeof(header.magic)) == 0
+                 && header.dimension >= 4 && header.dimension <= MAX_DIMENSION;
+    if (valid) {
+        file->dimension = header.dimension;
+        file->numWords = (file->dimension * file->dimension + 63) / 64;
+        file->recordSize = header.recordSize;
+        file->numPositions = header.numPositions;
+        valid = file->recordSize == 8 + 2 * 8 * (size_t)file->numWords
+                && file->numPositions <= (file->mappedSize - sizeof(header)) / file->recordSize;
+    }
+    if (!valid) {
+        munmap(file->data, file->mappedSize);
+        close(file->fd);
+        return false;
+    }
+    return true;
+}
+
+//Resizes a position file being written and maps it again with room for the given number of records
+bool reservePositions(PositionFile *file, uint64_t capacity) {
+    size_t size = sizeof(PositionFileHeader) + capacity * file->recordSize;
+    if (file->data != NULL) {
+        munmap(file->data, file->mappedSize);
+        file->data = NULL;
+    }
+    if (ftruncate(file->fd, size) != 0) {
+        return false;
+    }
+    file->data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+    if (file->data == MAP_FAILED) {
+        file->data = NULL;
+        return false;
+    }
+    file->mappedSize = size;
+    file->capacity = capacity;
+    return true;
+}
+
+//Creates a binary position file for boards of one dimension and maps it for writing
+bool createPositionFile(const char *fileName, int boardDimension, uint64_t capacity, PositionFile *file) {
+    memset(file, 0, sizeof(PositionFile));
+    file->fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file->fd < 0) {
+        return false;
+    }
+    file->writable = true;
+    file->dimension = boardDimension;
+    file->numWords = (boardDimension * boardDimension + 63) / 64;
+    file->recordSize = 8 + 2 * 8 * file->numWords;
+    if (!reservePositions(file, capacity > 0 ? capacity : 1)) {
+        close(file->fd);
+        return false;
+    }
+    return true;
+}
+
+//Gets the bytes of a record in a mapped position file
+unsigned char *getPositionRecord(const PositionFile *file, uint64_t index) {
+    return file->data + sizeof(PositionFileHeader) + index * file->recordSize;
+}
+
+/**Finishes with a position file, writing the header and trimming unused records from a file being written
+ * Returns false if a file being written could not be completed
+ */
+bool closePositionFile(PositionFile *file) {
+    bool success = true;
+    if (file->writable && file->data != NULL) {
+        PositionFileHeader header = {POSITION_FILE_MAGIC, file->dimension, file->recordSize, file->numPositions};
+        memcpy(file->data, &header, sizeof(header));
+        success = msync(file->data, file->mappedSize, MS_SYNC) == 0;
+    }
+    if (file->data != NULL) {
+        munmap(file->data, file->mappedSize);
+    }
+    if (file->writable) {
+        success = success && file->data != NULL
+                  && ftruncate(file->fd, sizeof(PositionFileHeader) + file->numPositions * file->recordSize) == 0;
+    }
+    file->data = NULL;
+    return close(file->fd) == 0 && success;
+}
+
+//Packs a game state and a move into a position record, row and col are -1 if there is no move
+void encodePosition(unsigned char *record, const PositionFile *file, const GameState *state, int row, int col) {
+    memset(record, 0, 8);
+    record[0] = state->turn;
+    record[1] = row < 0 ? NO_POSITION_MOVE : row;
+    record[2] = col < 0 ? NO_POSITION_MOVE : col;
+    memcpy(record + 8, state->board.black.words, 8 * file->numWords);
+    memcpy(record + 8 + 8 * file->numWords, state->board.white.words, 8 * file->numWords);
+}
+
+//Unpacks a position record into a game state, along with its move's row and col (-1 if none)
+void decodePosition(const unsigned char *record, const PositionFile *file, GameState *state, int *row, int *col) {
+    setupBitBoard(&state->board, file->dimension);
+    memcpy(state->board.black.words, record + 8, 8 * file->numWords);
+    memcpy(state->board.white.words, record + 8 + 8 * file->numWords, 8 * file->numWords);
+    
+    //Ignore bits off the board or set for both colours in a damaged file
+    const BitBoardMasks *masks = getBitBoardMasks(file->dimension);
+    for (int i = 0; i < file->numWords; i++) {
+        state->board.black.words[i] &= masks->onBoard.words[i];
+        state->board.white.words[i] &= masks->onBoard.words[i] & ~state->board.black.words[i];
+    }
+    startGameState(state, record[0] == 'W' ? 'W' : 'B');
+    *row = record[1] == NO_POSITION_MOVE ? -1 : record[1];
+    *col = record[2] == NO_POSITION_MOVE ? -1 : record[2];
+}
+
+/**Counts the leaves of the game tree a number of moves below a position
+ * A colour with no valid move passes, and the pass counts as a move
+ * A finished game is a leaf even if it ends before the depth is reached
+ * Every position visited, including the leaves, is added to the node count
+ */
+long long perft(GameState *state, int depth, long long *nodes) {
+    (*nodes)++;
+    if (depth == 0) {
+        return 1;
+    }
+    
+    MoveList moves;
+    generateBitBoardMoves(&state->board, state->turn, &moves);
+    
+    //Pass if the other colour can still move, otherwise the game is over
+    if (moves.numMoves == 0) {
+        if (countBitBoardMoves(&state->board, oppositeOf(state->turn)) == 0) {
+            return 1;
+        }
+        passGameState(state);
+        long long leaves = perft(state, depth - 1, nodes);
+        undoGameStateMove(state);
+        return leaves;
+    }
+    
+    long long leaves = 0;
+    for (int i = 0; i < moves.numMoves; i++) {
+        makeGameStateMove(state, &moves.moves[i]);
+        leaves += perft(state, depth - 1, nodes);
+        undoGameStateMove(state);
+    }
+    return leaves;
+}
+
+/**Runs perft from every position in a position file: "perft --positions <file> <depth>"
+ * Prints the leaves below each position, then the totals and speed
+ */
+int runPerftPositions(const char *fileName, int depth) {
+    PositionFile file;
+    if (!openPositionFile(fileName, &file)) {
+        fprintf(stderr, "%s is not a position file.\n", fileName);
+        return 1;
+    }
+    GameState *state = malloc(sizeof(GameState));
+    if (state == NULL) {
+        closePositionFile(&file);
+        return 1;
+    }
+    initZobristKeys();
+    
+    long long leaves = 0, nodes = 0;
+    int row = -1, col = -1;
+    double start = getSeconds();
+    for (uint64_t i = 0; i < file.numPositions; i++) {
+        decodePosition(getPositionRecord(&file, i), &file, state, &row, &col);
+        long long positionLeaves = perft(state, depth, &nodes);
+        printf("%llu %lld\n", (unsigned long long) i, positionLeaves);
+        leaves += positionLeaves;
+    }
+    double seconds = getSeconds() - start;
+    
+    printf("Positions: %llu (%dx%d)\n", (unsigned long long) file.numPositions, file.dimension, file.dimension);
+    printf("Leaves: %lld\n", leaves);
+    printf("Nodes: %lld\n", nodes);
+    printf("Time: %.3f s\n", seconds);
+    printf("Nodes per second: %.0f\n", seconds > 0 ? nodes / seconds : 0.0);
+    free(state);
+    closePositionFile(&file);
+    return 0;
+}
+
+/**Runs perft from the starting position: "perft <dimension> <depth>"
+ * Prints the leaves below each move from the start (divide), then the totals and speed
+ */
+int runPerft(int argc, char **argv) {
+    if (argc == 5 && strcmp(argv[2], "--positions") == 0) {
+        int depth = atoi(argv[4]);
+        if (depth < 0 || depth > MAX_UNDO) {
+            fprintf(stderr, "Depth must be from 0 to %d.\n", MAX_UNDO);
+            return 1;
+        }
+        return runPerftPositions(argv[3], depth);
+    }
+    if (argc != 4) {
+        fprintf(stderr, "Usage: %s perft <dimension> <depth>\n", argv[0]);
+        fprintf(stderr, "       %s perft --positions <file> <depth>\n", argv[0]);
+        return 1;
+    }
+    int boardDimension = atoi(argv[2]);
+    int depth = atoi(argv[3]);
+    if (boardDimension < 4 || boardDimension > MAX_DIMENSION || depth < 1 || depth > MAX_UNDO) {
+        fprintf(stderr, "Dimension must be from 4 to %d and depth from 1 to %d.\n", MAX_DIMENSION, MAX_UNDO);
+        return 1;
+    }
+    
+    //Start from the same position as a game
+    GameState state;
+    initZobristKeys();
+    setupGameState(boardDimension, 'B', &state);
+    
+    MoveList moves;
+    generateBitBoardMoves(&state.board, state.turn, &moves);
+    
+    long long leaves = 0, nodes = 1;
+    double start = getSeconds();
+    for (int i = 0; i < moves.numMoves; i++) {
+        makeGameStateMove(&state, &moves.moves[i]);
+        long long moveLeaves = perft(&state, depth - 1, &nodes);
+        undoGameStateMove(&state);
+        printf("%c%c %lld\n", moves.moves[i].row + 'a', moves.moves[i].col + 'a', moveLeaves);
+        leaves += moveLeaves;
+    }
+    double seconds = getSeconds() - start;
+    
+    printf("Leaves: %lld\n", leaves);
+    printf("Nodes: %lld\n", nodes);
+    printf("Time: %.3f s\n", seconds);
+    printf("Nodes per second: %.0f\n", seconds > 0 ? nodes / seconds : 0.0);
+    return 0;
+}
+
+/**Solves every position in a position file exactly: "solve <file> [--wld]"
+ * Prints each position's best move (-- if it must pass), final disc difference (or its sign with --wld) and nodes,
+ * then the totals and speed
+ */
+int runSolve(int argc, char **argv) {
+    bool winLossDraw = argc == 4 && strcmp(argv[3], "--wld") == 0;
+    if (argc != 3 && !winLossDraw) {
+        fprintf(stderr, "Usage: %s solve <file> [--wld]\n", argv[0]);
+        return 1;
+    }
+    PositionFile file;
+    if (!openPositionFile(argv[2], &file)) {
+        fprintf(stderr, "%s is not a position file.\n", argv[2]);
+        return 1;
+    }
+    GameState *state = malloc(sizeof(GameState));
+    if (state == NULL) {
+        closePositionFile(&file);
+        return 1;
+    }
+    initZobristKeys();
+    
+    long long nodes = 0;
+    int row = -1, col = -1;
+    double start = getSeconds();
+    for (uint64_t i = 0; i < file.numPositions; i++) {
+        EndgameInfo info = {0};
+        info.winLossDraw = winLossDraw;
+        decodePosition(getPositionRecord(&file, i), &file, state, &row, &col);
+        
+        MoveList moves;
+        generateBitBoardMoves(&state->board, state->turn, &moves);
+        if (moves.numMoves > 0) {
+            const Move *move = &moves.moves[solveEndgame(state, &moves, &info)];
+            printf("%llu %c%c %d %lld\n", (unsigned long long) i, move->row + 'a', move->col + 'a', info.score, info.nodes);
+        }
+        else {
+            int limit = winLossDraw ? 1 : ENDGAME_SCORE_LIMIT;
+            info.score = solveGameState(state, -limit, limit, false, &info);
+            if (winLossDraw) {
+                info.score = info.score > 0 ? 1 : info.score < 0 ? -1 : 0;
+            }
+            printf("%llu -- %d %lld\n", (unsigned long long) i, info.score, info.nodes);
+        }
+        nodes += info.nodes;
+    }
+    double seconds = getSeconds() - start;
+    
+    printf("Positions: %llu (%dx%d)\n", (unsigned long long) file.numPositions, file.dimension, file.dimension);
+    printf("Nodes: %lld\n", nodes);
+    printf("Time: %.3f s\n", seconds);
+    printf("Nodes per second: %.0f\n", seconds > 0 ? nodes / seconds : 0.0);
+    free(state);
+    closePositionFile(&file);
+    return 0;
+}
+
+//Prints out the command line options
+void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [options]\n", program);
+    fprintf(stderr, "       %s perft <dimension> <depth>\n", program);
+    fprintf(stderr, "       %s perft --positions <file> <depth>\n", program);
+    fprintf(stderr, "       %s solve <file> [--wld]\n", program);
+    fprintf(stderr, "       %s book <file> [--dimension N] [--moves M] [--positions FILE] [--depth D] [--hash MB]\n", program);
+    fprintf(stderr, "                [--threads T]\n");
+    fprintf(stderr, "       %s selfplay [--games M] [--dimension N] [--black ENGINE] [--white ENGINE]\n", program);
+    fprintf(stderr, "                [--threads T] [--seed S] [--opening K] [--hash MB] [--positions FILE] [--book FILE]\n");
+    fprintf(stderr, "                [--tree MB] [--exploration C]\n");
+    fprintf(stderr, "                ENGINE is greedy, random, search:<depth> or mcts:<playouts>\n");
+    fprintf(stderr, "  --depth N    computer searches N moves ahead (0 keeps the greedy computer)\n");
+    fprintf(stderr, "  --nodes N    computer stops searching after N positions per move\n");
+    fprintf(stderr, "  --hash MB    size of the search's hash table in megabytes (default 16, 0 for none)\n");
+    fprintf(stderr, "  --threads N  computer searches with N threads sharing the hash table (default 1)\n");
+    fprintf(stderr, "  --book FILE  computer plays from an opening book before searching\n");
+    fprintf(stderr, "  --endgame N  computer solves the game exactly once N or fewer positions are unoccupied\n");
+    fprintf(stderr, "  --wld        endgame solver only finds a win, loss or draw, which is faster\n");
+    fprintf(stderr, "  --mcts N     computer plays N Monte Carlo tree search playouts per move instead of searching\n");
+    fprintf(stderr, "  --mcts-time MS\n");
+    fprintf(stderr, "               computer plays Monte Carlo playouts for at most MS milliseconds per move\n");
+    fprintf(stderr, "  --exploration C\n");
+    fprintf(stderr, "               weight of exploration in the Monte Carlo tree search (default 1.4)\n");
+    fprintf(stderr, "  --movetime MS\n");
+    fprintf(stderr, "               computer takes at most MS milliseconds per move, searching as deep as time allows\n");
+    fprintf(stderr, "  --time-control S[+I]\n");
+    fprintf(stderr, "               computer has S seconds for the game, plus I seconds after each move\n");
+    fprintf(stderr, "  --ponder     computer searches while waiting for the player's move\n");
+    fprintf(stderr, "  --tree MB    size of the Monte Carlo search tree's arena in megabytes (default 64)\n");
+    fprintf(stderr, "  --render full|diff|silent\n");
+    fprintf(stderr, "               show the whole board after each move (default), only the positions that changed,\n");
+    fprintf(stderr, "               with the board fixed at the top of the terminal, or no board\n");
+    fprintf(stderr, "  --stats json|json-moves\n");
+    fprintf(stderr, "               count the work done and write it as JSON on stderr, for the game or each move too\n");
+    fprintf(stderr, "               (needs a build with -DOTHELLO_STATS)\n");
+    fprintf(stderr, "  --verbose    report each search and the hash table usage on stderr\n");
+}
+
+//Entries of an opening book being built, and the positions already visited while building it
+typedef struct {
+    const OpeningBook *existing; //Book being expanded, its entries are kept unless searched again more deeply
+    BookEntry *entries;
+    uint64_t numEntries;
+    uint64_t capacity;
+    uint64_t *seen; //Canonical hashes of visited positions by open addressing, zero for an empty slot
+    uint64_t seenMask;
+    uint64_t numSeen;
+    SearchInfo info; //Settings for each search, and the nodes of every search so far
+    int threads;
+    long long nodes;
+    long long searches;
+} BookBuilder;
+
+//Adds an entry to a book being built, returns false if there is no memory for it
+bool addBookEntry(BookBuilder *builder, const BookEntry *entry) {
+    if (builder->numEntries == builder->capacity) {
+        uint64_t capacity = builder->capacity > 0 ? 2 * builder->capacity : 1024;
+        BookEntry *entries = realloc(builder->entries, capacity * sizeof(BookEntry));
+        if (entries == NULL) {
+            return false;
+        }
+        builder->entries = entries;
+        builder->capacity = capacity;
+    }
+    builder->entries[builder->numEntries++] = *entry;
+    return true;
+}
+
+//Records that a position has been visited, returns false if it had been visited already
+bool markBookPosition(BookBuilder *builder, uint64_t hash) {
+    
+    //Double the set once it is half full
+    if (2 * (builder->numSeen + 1) > builder->seenMask + 1) {
+        uint64_t size = builder->seen != NULL ? 2 * (builder->seenMask + 1) : 4096;
+        uint64_t *seen = calloc(size, sizeof(uint64_t));
+        if (seen == NULL) {
+            return true;
+        }
+        for (uint64_t i = 0; builder->seen != NULL && i <= builder->seenMask; i++) {
+            if (builder->seen[i] != 0) {
+                uint64_t slot = builder->seen[i] & (size - 1);
+                while (seen[slot] != 0) {
+                    slot = (slot + 1) & (size - 1);
+                }
+                seen[slot] = builder->seen[i];
+            }
+        }
+        free(builder->seen);
+        builder->seen = seen;
+        builder->seenMask = size - 1;
+    }
+    
+    uint64_t slot = hash & builder->seenMask;
+    while (builder->seen[slot] != 0) {
+        if (builder->seen[slot] == hash) {
+            return false;
+        }
+        slot = (slot + 1) & builder->seenMask;
+    }
+    builder->seen[slot] = hash;
+    builder->numSeen++;
+    return true;
+}
+
+//Searches a position for the book unless the book already has it searched at least as deeply
+void searchBookPosition(BookBuilder *builder, GameState *state) {
+    MoveList moves;
+    BookEntry entry;
+    generateBitBoardMoves(&state->board, state->turn, &moves);
+    if (moves.numMoves == 0) {
+        return;
+    }
+    if (builder->existing != NULL && probeOpeningBook(builder->existing, state, &entry)
+        && entry.depth >= builder->info.maxDepth)
+    {
+        return;
+    }
+    
+    //Store the move on the canonical form, which every symmetry of the position shares
+    SearchInfo info = builder->info;
+    const Move *move = &moves.moves[chooseSearchMove(state, &moves, &info, builder->threads)];
+    int symmetry = 0;
+    entry.hash = computeCanonicalHash(state, &symmetry);
+    entry.score = info.bestScore;
+    entry.bestSquare = transformSquare(state->board.dimension, symmetry, move->row * state->board.dimension + move->col);
+    entry.depth = info.completedDepth;
+    addBookEntry(builder, &entry);
+    builder->nodes += info.nodes;
+    builder->searches++;
+}
+
+/**Searches every position reached in fewer than the number of moves given from a position
+ * A pass counts as a move, and a position reached again by a different order of moves, or a rotation or reflection
+ * of one already reached, is only searched once
+ */
+void expandBook(BookBuilder *builder, GameState *state, int moves) {
+    int symmetry = 0;
+    if (moves == 0 || !markBookPosition(builder, computeCanonicalHash(state, &symmetry))) {
+        return;
+    }
+    searchBookPosition(builder, state);
+    
+    MoveList moveList;
+    generateBitBoardMoves(&state->board, state->turn, &moveList);
+    if (moveList.numMoves == 0) {
+        if (countBitBoardMoves(&state->board, oppositeOf(state->turn)) > 0) {
+            passGameState(state);
+            expandBook(builder, state, moves - 1);
+            undoGameStateMove(state);
+        }
+        return;
+    }
+    for (int i = 0; i < moveList.numMoves; i++) {
+        makeGameStateMove(state, &moveList.moves[i]);
+        expandBook(builder, state, moves - 1);
+        undoGameStateMove(state);
+    }
+}
+
+//Orders book entries by hash, deepest search first for the same hash
+int compareBookEntries(const void *first, const void *second) {
+    const BookEntry *a = first, *b = second;
+    if (a->hash != b->hash) {
+        return a->hash < b->hash ? -1 : 1;
+    }
+    return b->depth - a->depth;
+}
+
+/**Writes the entries of a book being built to a file, sorted by hash with one entry for each position
+ * The book is written to a temporary file that replaces the file given, so a book can be expanded in place
+ */
+bool writeOpeningBook(BookBuilder *builder, const char *fileName, int boardDimension) {
+    qsort(builder->entries, builder->numEntries, sizeof(BookEntry), compareBookEntries);
+    uint64_t numEntries = 0;
+    for (uint64_t i = 0; i < builder->numEntries; i++) {
+        if (numEntries == 0 || builder->entries[numEntries - 1].hash != builder->entries[i].hash) {
+            builder->entries[numEntries++] = builder->entries[i];
+        }
     }
+    builder->numEntries = numEntries;
     
-    //Count how many tiles need to be flipped in each direction
-    int numFlipNorth = searchNorth(row, col, player, board, boardDimension);
-    int numFlipNorthEast = searchNorthEast(row, col, player, board, boardDimension);
-    int numFlipEast = searchEast(row, col, player, board, boardDimension);
-    int numFlipSouthEast = searchSouthEast(row, col, player, board, boardDimension);
-    int numFlipSouth = searchSouth(row, col, player, board, boardDimension);
-    int numFlipSouthWest = searchSouthWest(row, col, player, board, boardDimension);
-    int numFlipWest = searchWest(row, col, player, board, boardDimension);
-    int numFlipNorthWest = searchNorthWest(row, col, player, board, boardDimension);
-    
-    //If all of these values are 0 (sum is 0), no flips can be made, and move is invalid
-    if (numFlipNorth + numFlipNorthEast + numFlipEast + numFlipSouthEast + 
-        numFlipSouth + numFlipSouthWest + numFlipWest + numFlipNorthWest == 0) 
-    {
+    char tempName[4096];
+    snprintf(tempName, sizeof(tempName), "%s.tmp", fileName);
+    FILE *file = fopen(tempName, "wb");
+    if (file == NULL) {
         return false;
     }
+    BookFileHeader header = {BOOK_FILE_MAGIC, boardDimension, sizeof(BookEntry), numEntries};
+    bool success = fwrite(&header, sizeof(header), 1, file) == 1
+                   && fwrite(builder->entries, sizeof(BookEntry), numEntries, file) == numEntries;
+    success = fclose(file) == 0 && success;
+    return success && rename(tempName, fileName) == 0;
+}
+
+/**Builds or expands an opening book:
+ * "book <file> [--dimension N] [--moves M] [--positions FILE] [--depth D] [--hash MB] [--threads T]"
+ * Searches every position in the first M moves from the start (default 6), and every position in a position file
+ * such as one saved by self-play, keeping entries already in the book unless they are searched more deeply
+ */
+int runBook(int argc, char **argv) {
+    const char *fileName = argc > 2 ? argv[2] : NULL;
+    const char *positionFileName = NULL;
+    int boardDimension = 0, numMoves = 6, hashMegabytes = 16;
+    BookBuilder builder = {0};
+    builder.info.maxDepth = 8;
+    builder.threads = 1;
     
-    //At this point, moves can be made
-    
-    //Make the moves that can be made
-    if (numFlipNorth > 0) {
-        flipNorth(board, row, col, numFlipNorth, player);
+    bool valid = fileName != NULL && fileName[0] != '-';
+    for (int i = 3; valid && i < argc; i++) {
+        valid = i + 1 < argc;
+        if (valid && strcmp(argv[i], "--dimension") == 0) {
+            boardDimension = atoi(argv[++i]);
+            valid = boardDimension >= 4 && boardDimension <= MAX_DIMENSION;
+        }
+        else if (valid && strcmp(argv[i], "--moves") == 0) {
+            numMoves = atoi(argv[++i]);
+            valid = numMoves >= 0;
+        }
+        else if (valid && strcmp(argv[i], "--positions") == 0) {
+            positionFileName = argv[++i];
+        }
+        else if (valid && strcmp(argv[i], "--depth") == 0) {
+            builder.info.maxDepth = atoi(argv[++i]);
+            valid = builder.info.maxDepth >= 1 && builder.info.maxDepth <= MAX_SEARCH_DEPTH;
+        }
+        else if (valid && strcmp(argv[i], "--hash") == 0) {
+            hashMegabytes = atoi(argv[++i]);
+            valid = hashMegabytes >= 0;
+        }
+        else if (valid && strcmp(argv[i], "--threads") == 0) {
+            builder.threads = atoi(argv[++i]);
+            valid = builder.threads >= 1;
+        }
+        else {
+            valid = false;
+        }
     }
-    if (numFlipNorthEast > 0) {
-        flipNorthEast(board, row, col, numFlipNorthEast, player);
+    if (!valid) {
+        printUsage(argv[0]);
+        return 1;
     }
-    if (numFlipEast > 0) {
-        flipEast(board, row, col, numFlipEast, player);
+    
+    //Keep the entries of a book that is being expanded, it decides the dimension
+    OpeningBook existing;
+    if (openOpeningBook(fileName, &existing)) {
+        if (boardDimension != 0 && boardDimension != existing.dimension) {
+            fprintf(stderr, "%s is a book for %dx%d boards.\n", fileName, existing.dimension, existing.dimension);
+            closeOpeningBook(&existing);
+            return 1;
+        }
+        boardDimension = existing.dimension;
+        builder.existing = &existing;
+        for (uint64_t i = 0; i < existing.numEntries; i++) {
+            addBookEntry(&builder, &existing.entries[i]);
+        }
     }
-    if (numFlipSouthEast > 0) {
-        flipSouthEast(board, row, col, numFlipSouthEast, player);
+    if (boardDimension == 0) {
+        boardDimension = 8;
     }
-    if (numFlipSouth > 0) {
-        flipSouth(board, row, col, numFlipSouth, player);
+    
+    //A position file that cannot be used stops the build before anything is searched or written
+    PositionFile positionFile;
+    bool positionsOpen = positionFileName != NULL && openPositionFile(positionFileName, &positionFile);
+    bool ready = positionFileName == NULL || (positionsOpen && positionFile.dimension == boardDimension);
+    if (!ready) {
+        fprintf(stderr, "%s is not a position file for %dx%d boards.\n", positionFileName, boardDimension, boardDimension);
     }
-    if (numFlipSouthWest > 0) {
-        flipSouthWest(board, row, col, numFlipSouthWest, player);
+    
+    HashTable table = {0};
+    GameState *state = malloc(sizeof(GameState));
+    initZobristKeys();
+    if (ready && (state == NULL || (hashMegabytes > 0 && !createHashTable(&table, hashMegabytes)))) {
+        fprintf(stderr, "Could not allocate memory for building the book.\n");
+        ready = false;
     }
-    if (numFlipWest > 0) {
-        flipWest(board, row, col, numFlipWest, player);
+    if (!ready) {
+        if (positionsOpen) {
+            closePositionFile(&positionFile);
+        }
+        if (builder.existing != NULL) {
+            closeOpeningBook(&existing);
+        }
+        free(builder.entries);
+        free(builder.seen);
+        free(table.slots);
+        free(state);
+        return 1;
     }
-    if (numFlipNorthWest > 0) {
-        flipNorthWest(board, row, col, numFlipNorthWest, player);
+    builder.info.table = &table;
+    double start = getSeconds();
+    
+    //Search the positions near the start of the game
+    setupGameState(boardDimension, 'B', state);
+    expandBook(&builder, state, numMoves);
+    
+    //Search the positions in the position file
+    if (positionsOpen) {
+        int row = -1, col = -1;
+        for (uint64_t i = 0; i < positionFile.numPositions; i++) {
+            decodePosition(getPositionRecord(&positionFile, i), &positionFile, state, &row, &col);
+            int symmetry = 0;
+            if (markBookPosition(&builder, computeCanonicalHash(state, &symmetry))) {
+                searchBookPosition(&builder, state);
+            }
+        }
+        closePositionFile(&positionFile);
     }
+    double seconds = getSeconds() - start;
     
-    //Place player's chip at chosen position
-    board[row][col] = player;
+    if (builder.existing != NULL) {
+        closeOpeningBook(&existing);
+    }
+    bool written = writeOpeningBook(&builder, fileName, boardDimension);
     
-    return true;
+    printf("Book: %llu entries (%dx%d)\n", (unsigned long long) builder.numEntries, boardDimension, boardDimension);
+    printf("Searches: %lld to depth %d\n", builder.searches, builder.info.maxDepth);
+    printf("Nodes: %lld\n", builder.nodes);
+    printf("Time: %.3f s\n", seconds);
+    if (!written) {
+        fprintf(stderr, "Could not write %s.\n", fileName);
+    }
+    free(builder.entries);
+    free(builder.seen);
+    free(table.slots);
+    free(state);
+    return written ? 0 : 1;
 }
 
-//Checks to see if a specified position is valid for a move
-bool checkValidPosition(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //If there is a move to be made in any of the 8 directions, return true
-    //This is represented by the search in that direction being greater than zero
-    
-    if (searchNorth(row, col, colour, board, boardDimension) > 0) {
+//Ways a computer can choose its moves in self-play
+enum EngineType {
+    ENGINE_GREEDY, //Most flips, like the interactive computer
+    ENGINE_RANDOM, //Any valid move
+    ENGINE_SEARCH, //Alpha-beta search to a fixed depth
+    ENGINE_MCTS //Monte Carlo tree search with a fixed number of playouts
+};
+
+//Computer playing one colour in self-play
+typedef struct {
+    int type;
+    int depth; //Search depth for ENGINE_SEARCH
+    long long playouts; //Playouts per move for ENGINE_MCTS
+    double exploration; //Exploration weight for ENGINE_MCTS
+} Engine;
+
+//Settings for a batch of self-play games
+typedef struct {
+    long long numGames;
+    int dimension;
+    int threads;
+    int openingMoves; //Random moves played at the start of each game so games differ
+    int hashMegabytes; //Hash table of each thread for search engines
+    uint64_t seed;
+    Engine engines[2]; //Indexed like the Zobrist keys, Black first
+    PositionFile *positionFile; //Gets the position after each game's opening, NULL if positions are not saved
+    OpeningBook book; //Played from by search engines, empty if there is no book
+    int treeMegabytes; //Search tree arena of each thread for Monte Carlo engines
+} SelfPlaySettings;
+
+//Results of self-play games, each thread adds up its own
+typedef struct {
+    long long games;
+    long long wins[2]; //Indexed like the Zobrist keys, Black first
+    long long draws;
+    long long discMargin; //Black discs minus White discs, summed over games
+    long long moves; //Tiles placed, summed over games
+    long long passes;
+} SelfPlayResults;
+
+//Work shared by the self-play threads
+typedef struct {
+    const SelfPlaySettings *settings;
+    atomic_llong nextGame;
+    SelfPlayResults results;
+    pthread_mutex_t resultsLock;
+} SelfPlayBatch;
+
+//Reads an engine name: greedy, random, search:<depth> or mcts:<playouts>, returns false if the name is not recognised
+bool parseEngine(const char *text, Engine *engine) {
+    if (strcmp(text, "greedy") == 0) {
+        engine->type = ENGINE_GREEDY;
         return true;
     }
-    else if (searchNorthEast(row, col, colour, board, boardDimension) > 0) {
+    if (strcmp(text, "random") == 0) {
+        engine->type = ENGINE_RANDOM;
         return true;
     }
-    else if (searchEast(row, col, colour, board, boardDimension) > 0) {
-        return true;
+    if (strncmp(text, "search:", 7) == 0) {
+        engine->type = ENGINE_SEARCH;
+        engine->depth = atoi(text + 7);
+        return engine->depth >= 1 && engine->depth <= MAX_SEARCH_DEPTH;
     }
-    else if (searchSouthEast(row, col, colour, board, boardDimension) > 0) {
-        return true;
+    if (strncmp(text, "mcts:", 5) == 0) {
+        engine->type = ENGINE_MCTS;
+        engine->playouts = atoll(text + 5);
+        engine->exploration = MCTS_EXPLORATION;
+        return engine->playouts >= 1;
     }
-    else if (searchSouth(row, col, colour, board, boardDimension) > 0) {
-        return true;
+    return false;
+}
+
+//Writes an engine's name into a buffer
+void formatEngine(const Engine *engine, char *text, int size) {
+    if (engine->type == ENGINE_GREEDY) {
+        snprintf(text, size, "greedy");
     }
-    else if (searchSouthWest(row, col, colour, board, boardDimension) > 0) {
-        return true;
+    else if (engine->type == ENGINE_RANDOM) {
+        snprintf(text, size, "random");
     }
-    else if (searchWest(row, col, colour, board, boardDimension) > 0) {
-        return true;
+    else if (engine->type == ENGINE_SEARCH) {
+        snprintf(text, size, "search:%d", engine->depth);
     }
-    else if (searchNorthWest(row, col, colour, board, boardDimension) > 0) {
-        return true;
+    else {
+        snprintf(text, size, "mcts:%lld", engine->playouts);
     }
-    return false;
 }
 
-//Evaluates and scores a potential move for the computer to make
-int evaluatePosition(int row, int col, char colour, char board[][26], int boardDimension) {
-    int score = 0;
-    
-    //Search in all eight directions
-    score += searchNorth(row, col, colour, board, boardDimension);
-    score += searchNorthEast(row, col, colour, board, boardDimension);
-    score += searchEast(row, col, colour, board, boardDimension);
-    score += searchSouthEast(row, col, colour, board, boardDimension);
-    score += searchSouth(row, col, colour, board, boardDimension);
-    score += searchSouthWest(row, col, colour, board, boardDimension);
-    score += searchWest(row, col, colour, board, boardDimension);
-    score += searchNorthWest(row, col, colour, board, boardDimension);
+/**Chooses the move an engine plays from a list of valid moves, returns the index of the move in the list
+ * Search engines play from the opening book first if there is one
+ */
+int chooseEngineMove(const Engine *engine, GameState *state, const MoveList *moves, HashTable *table, MctsArena *arena,
+                     const OpeningBook *book, uint64_t *random)
+{
+    int bestIndex = 0;
+    BookEntry entry;
+    const Move *bookMove = NULL;
     
-    return score;
-}
-
-//Count number of valid positions
-int countValidPositions(char board[][26], int boardDimension, char colour) {
-    int numValidPositions = 0;
+    if (engine->type == ENGINE_SEARCH && probeOpeningBook(book, state, &entry)) {
+        bookMove = findMove(moves, entry.bestSquare / state->board.dimension, entry.bestSquare % state->board.dimension);
+    }
     
-    //Iterate through all positions on board
-    for (int row = 0; row < boardDimension; row++) {
-        for (int col = 0; col < boardDimension; col++) {
-            
-            //Ensure position is unoccupied and position is valid
-            if (board[row][col] == 'U' && checkValidPosition(row, col, colour, board, boardDimension)) {
-                numValidPositions++;
+    if (engine->type == ENGINE_RANDOM) {
+        bestIndex = nextRandom(random) % moves->numMoves;
+    }
+    else if (bookMove != NULL) {
+        bestIndex = bookMove - moves->moves;
+    }
+    else if (engine->type == ENGINE_SEARCH) {
+        SearchInfo info = {0};
+        info.maxDepth = engine->depth;
+        info.table = table;
+        bestIndex = chooseSearchMove(state, moves, &info, 1);
+    }
+    else if (engine->type == ENGINE_MCTS && arena->nodes != NULL) {
+        MctsSearch search = {0};
+        search.arena = arena;
+        search.exploration = engine->exploration;
+        search.maxPlayouts = engine->playouts;
+        search.seed = nextRandom(random);
+        bestIndex = chooseMctsMove(state, moves, &search, 1);
+    }
+    else {
+        for (int i = 1; i < moves->numMoves; i++) {
+            if (moves->moves[i].totalFlips > moves->moves[bestIndex].totalFlips) {
+                bestIndex = i;
             }
         }
     }
-    return numValidPositions;
+    return bestIndex;
 }
 
-//Makes the best move for the computer
-void makeComputerMove(char board[][26], int boardDimension, char computer) {
-    int bestRow = 0, bestCol = 0;
-    int bestScore = 0, score = 0;
+/**Plays one self-play game from the starting position without printing anything
+ * Uses the same rules as the interactive game: a colour with no valid move passes, and the game ends when
+ * neither colour can move
+ * If record is not NULL the position after the opening, or the final position if the game ends first, is saved there
+ */
+void playSelfPlayGame(const SelfPlaySettings *settings, GameState *state, HashTable *table, MctsArena *arena,
+                      uint64_t *random, SelfPlayResults *results, unsigned char *record)
+{
+    MoveList moves;
+    int moveNumber = 0;
+    bool passed = false;
     
-    //Iterate through all the positions on the board
-    for (int row = 0; row < boardDimension; row++) {
-        for (int col = 0; col < boardDimension; col++) {
-            
-            //If position is unoccupied and position is valid
-            if (board[row][col] == 'U' && checkValidPosition(row, col, computer, board, boardDimension)) {
-                
-                //Evaluate this position
-                score = evaluatePosition(row, col, computer, board, boardDimension);
-                
-                //If this is the best position so far, save this position
-                if (score > bestScore) {
-                    bestScore = score;
-                    bestRow = row;
-                    bestCol = col;
-                }
+    //Each game starts with an empty hash table, so its moves do not depend on the games played before it on this thread
+    setupGameState(settings->dimension, 'B', state);
+    clearHashTable(table);
+    
+    while (true) {
+        if (record != NULL && moveNumber >= settings->openingMoves) {
+            encodePosition(record, settings->positionFile, state, -1, -1);
+            record = NULL;
+        }
+        
+        generateBitBoardMoves(&state->board, state->turn, &moves);
+        
+        //Pass if there is no available move, the game is over after two passes in a row
+        if (moves.numMoves == 0) {
+            if (passed) {
+                break;
             }
+            passGameState(state);
+            passed = true;
+            results->passes++;
+            continue;
         }
+        passed = false;
+        
+        //Play a random opening, then let the engine for the colour to move choose
+        int index = 0;
+        if (moveNumber < settings->openingMoves) {
+            index = nextRandom(random) % moves.numMoves;
+        }
+        else {
+            index = chooseEngineMove(&settings->engines[colourIndex(state->turn)], state, &moves, table, arena,
+                                     &settings->book, random);
+        }
+        makeGameStateMove(state, &moves.moves[index]);
+        moveNumber++;
+        
+        //Only the last position is needed, so keep the undo stack from growing
+        state->undoDepth = 0;
     }
-    
-    //At this point, a move has been chosen
-    int row = bestRow;
-    int col = bestCol;
-    
-    //Count how many tiles need to be flipped in each direction
-    int numFlipNorth = searchNorth(row, col, computer, board, boardDimension);
-    int numFlipNorthEast = searchNorthEast(row, col, computer, board, boardDimension);
-    int numFlipEast = searchEast(row, col, computer, board, boardDimension);
-    int numFlipSouthEast = searchSouthEast(row, col, computer, board, boardDimension);
-    int numFlipSouth = searchSouth(row, col, computer, board, boardDimension);
-    int numFlipSouthWest = searchSouthWest(row, col, computer, board, boardDimension);
-    int numFlipWest = searchWest(row, col, computer, board, boardDimension);
-    int numFlipNorthWest = searchNorthWest(row, col, computer, board, boardDimension);
-    
-    //Make the flips that can be made
-    if (numFlipNorth > 0) {
-        flipNorth(board, row, col, numFlipNorth, computer);
+    if (record != NULL) {
+        encodePosition(record, settings->positionFile, state, -1, -1);
     }
-    if (numFlipNorthEast > 0) {
-        flipNorthEast(board, row, col, numFlipNorthEast, computer);
+    
+    int numBlack = state->numDiscs[colourIndex('B')];
+    int numWhite = state->numDiscs[colourIndex('W')];
+    results->games++;
+    results->moves += moveNumber;
+    results->discMargin += numBlack - numWhite;
+    if (numBlack > numWhite) {
+        results->wins[colourIndex('B')]++;
     }
-    if (numFlipEast > 0) {
-        flipEast(board, row, col, numFlipEast, computer);
+    else if (numWhite > numBlack) {
+        results->wins[colourIndex('W')]++;
     }
-    if (numFlipSouthEast > 0) {
-        flipSouthEast(board, row, col, numFlipSouthEast, computer);
+    else {
+        results->draws++;
     }
-    if (numFlipSouth > 0) {
-        flipSouth(board, row, col, numFlipSouth, computer);
+}
+
+/**Plays self-play games on one thread until the batch runs out
+ * Each game gets its own random numbers seeded from the batch seed and the game number,
+ * so the results do not depend on the number of threads
+ */
+void *runSelfPlayThread(void *argument) {
+    SelfPlayBatch *batch = argument;
+    const SelfPlaySettings *settings = batch->settings;
+    SelfPlayResults results = {0};
+    HashTable table = {0};
+    MctsArena arena = {0};
+    GameState *state = malloc(sizeof(GameState));
+    if (state == NULL) {
+        fprintf(stderr, "Could not allocate memory for a self-play game.\n");
     }
-    if (numFlipSouthWest > 0) {
-        flipSouthWest(board, row, col, numFlipSouthWest, computer);
+    
+    /**Search engines get a hash table of their own on each thread, and Monte Carlo engines a search tree arena
+     * A thread that cannot allocate them plays no games, leaving them to the other threads, rather than playing
+     * without them and changing the results
+     */
+    if (settings->engines[0].type == ENGINE_SEARCH || settings->engines[1].type == ENGINE_SEARCH) {
+        if (state != NULL && settings->hashMegabytes > 0 && !createHashTable(&table, settings->hashMegabytes)) {
+            fprintf(stderr, "Could not allocate memory for a self-play hash table.\n");
+            table.slots = NULL;
+            free(state);
+            state = NULL;
+        }
     }
-    if (numFlipWest > 0) {
-        flipWest(board, row, col, numFlipWest, computer);
+    if (settings->engines[0].type == ENGINE_MCTS || settings->engines[1].type == ENGINE_MCTS) {
+        if (state != NULL && !createMctsArena(&arena, settings->treeMegabytes)) {
+            fprintf(stderr, "Could not allocate memory for a self-play search tree arena.\n");
+            arena.nodes = NULL;
+            free(state);
+            state = NULL;
+        }
     }
-    if (numFlipNorthWest > 0) {
-        flipNorthWest(board, row, col, numFlipNorthWest, computer);
+    
+    long long game = 0;
+    while (state != NULL && (game = atomic_fetch_add(&batch->nextGame, 1)) < settings->numGames) {
+        uint64_t gameSeed = settings->seed + game;
+        uint64_t random = nextRandom(&gameSeed);
+        unsigned char *record = NULL;
+        if (settings->positionFile != NULL) {
+            record = getPositionRecord(settings->positionFile, game);
+        }
+        playSelfPlayGame(settings, state, &table, &arena, &random, &results, record);
     }
     
-    //Place computer's chip at chosen position
-    board[row][col] = computer;
+    //Add this thread's results to the batch
+    pthread_mutex_lock(&batch->resultsLock);
+    batch->results.games += results.games;
+    batch->results.wins[0] += results.wins[0];
+    batch->results.wins[1] += results.wins[1];
+    batch->results.draws += results.draws;
+    batch->results.discMargin += results.discMargin;
+    batch->results.moves += results.moves;
+    batch->results.passes += results.passes;
+    pthread_mutex_unlock(&batch->resultsLock);
     
-    //Output computer's move
-    char rowChar = row + 'a';
-    char colChar = col + 'a';
-    printf("Computer places %c at %c%c.\n", computer, rowChar, colChar);
+    free(table.slots);
+    free(arena.nodes);
+    free(state);
+    collectThreadStats();
+    return NULL;
 }
 
-//Checks to see if the game board is full
-bool isBoardFull(char board[][26], int boardDimension) {
+/**Runs a batch of self-play games without printing any boards:
+ * "selfplay [--games M] [--dimension N] [--black ENGINE] [--white ENGINE] [--threads T] [--seed S]
+ *  [--opening K] [--hash MB] [--positions FILE] [--book FILE] [--tree MB] [--exploration C]", where an engine is
+ *  greedy, random, search:<depth> or mcts:<playouts>
+ * With --positions, the position after each game's opening is saved to a position file in game order
+ * With --book, search engines play from an opening book before searching
+ * Monte Carlo engines build their trees in an arena of --tree megabytes on each thread, with --exploration weight
+ * Prints the wins, draws, average disc margin, average game length and games per second
+ */
+int runSelfPlay(int argc, char **argv) {
+    SelfPlaySettings settings = {1000, 8, 1, 0, 4, 1, {{ENGINE_GREEDY, 0, 0, 0}, {ENGINE_GREEDY, 0, 0, 0}}, NULL, {0}, 64};
+    const char *positionFileName = NULL, *bookFileName = NULL;
+    PositionFile positionFile;
+    double exploration = MCTS_EXPLORATION;
     
-    //Iterate through board, search for an unoccupied spot, meaning board is not full
-    for (int row = 0; row < boardDimension; row++) {
-        for (int col = 0; col < boardDimension; col++) {
-            if (board[row][col] == 'U') {
-                return false;
-            }
+    for (int i = 2; i < argc; i++) {
+        bool valid = i + 1 < argc;
+        if (valid && strcmp(argv[i], "--games") == 0) {
+            settings.numGames = atoll(argv[++i]);
+        }
+        else if (valid && strcmp(argv[i], "--dimension") == 0) {
+            settings.dimension = atoi(argv[++i]);
+            valid = settings.dimension >= 4 && settings.dimension <= MAX_DIMENSION;
+        }
+        else if (valid && strcmp(argv[i], "--black") == 0) {
+            valid = parseEngine(argv[++i], &settings.engines[colourIndex('B')]);
+        }
+        else if (valid && strcmp(argv[i], "--white") == 0) {
+            valid = parseEngine(argv[++i], &settings.engines[colourIndex('W')]);
+        }
+        else if (valid && strcmp(argv[i], "--threads") == 0) {
+            settings.threads = atoi(argv[++i]);
+            valid = settings.threads >= 1;
+        }
+        else if (valid && strcmp(argv[i], "--seed") == 0) {
+            settings.seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (valid && strcmp(argv[i], "--opening") == 0) {
+            settings.openingMoves = atoi(argv[++i]);
+        }
+        else if (valid && strcmp(argv[i], "--hash") == 0) {
+            settings.hashMegabytes = atoi(argv[++i]);
+            valid = settings.hashMegabytes >= 0;
+        }
+        else if (valid && strcmp(argv[i], "--positions") == 0) {
+            positionFileName = argv[++i];
+        }
+        else if (valid && strcmp(argv[i], "--book") == 0) {
+            bookFileName = argv[++i];
+        }
+        else if (valid && strcmp(argv[i], "--tree") == 0) {
+            settings.treeMegabytes = atoi(argv[++i]);
+            valid = settings.treeMegabytes >= 1;
+        }
+        else if (valid && strcmp(argv[i], "--exploration") == 0) {
+            exploration = atof(argv[++i]);
+            valid = exploration >= 0;
+        }
+        else {
+            valid = false;
+        }
+        
+        if (!valid) {
+            printUsage(argv[0]);
+            return 1;
         }
     }
-    return true;
-}
-
-//Checks to see if the game is over
-bool isGameOver(char board[][26], int boardDimension, char player, char computer) {
     
-    //If there are no valid moves for both player and computer, game is over
-    if (countValidPositions(board, boardDimension, player) + countValidPositions(board, boardDimension, computer) == 0) {
-        return true;
+    initZobristKeys();
+    getPatternEvaluator(settings.dimension);
+    settings.engines[0].exploration = settings.engines[1].exploration = exploration;
+    
+    if (bookFileName != NULL && (!openOpeningBook(bookFileName, &settings.book) || settings.book.dimension != settings.dimension)) {
+        fprintf(stderr, "%s is not an opening book for %dx%d boards.\n", bookFileName, settings.dimension, settings.dimension);
+        return 1;
     }
     
-    //If the board is full, game is over
-    if (isBoardFull(board, boardDimension)) {
-        return true;
+    //Every game writes its own record, so the file is sized for all of them before the threads start
+    if (positionFileName != NULL) {
+        if (settings.numGames < 1 || !createPositionFile(positionFileName, settings.dimension, settings.numGames, &positionFile)) {
+            fprintf(stderr, "Could not create position file %s.\n", positionFileName);
+            return 1;
+        }
+        positionFile.numPositions = settings.numGames;
+        settings.positionFile = &positionFile;
     }
     
-    return false;
-}
-
-//Determines the winner of the game
-char determineWinner(char board[][26], int boardDimension) {
-    int numWhite = 0, numBlack = 0;
+    //Start the threads, the calling thread waits for them
+    SelfPlayBatch batch = {0};
+    batch.settings = &settings;
+    atomic_init(&batch.nextGame, 0);
+    pthread_mutex_init(&batch.resultsLock, NULL);
+    pthread_t *threads = calloc(settings.threads, sizeof(pthread_t));
     
-    //Iterate through board and add up all white and black tiles
-    for (int row = 0; row < boardDimension; row++) {
-        for (int col = 0; col < boardDimension; col++) {
-            if (board[row][col] == 'W') {
-                numWhite++;
-            }
-            else if(board[row][col] == 'B') {
-                numBlack++;
-            }
+    double start = getSeconds();
+    int numStarted = 0;
+    for (int i = 0; i < settings.threads && threads != NULL; i++) {
+        if (pthread_create(&threads[i], NULL, runSelfPlayThread, &batch) != 0) {
+            break;
         }
+        numStarted++;
     }
-    
-    //Return winning character, or 0 if a draw
-    if (numWhite == numBlack) {
-        return 0;
+    if (numStarted == 0) {
+        runSelfPlayThread(&batch);
+    }
+    for (int i = 0; i < numStarted; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    double seconds = getSeconds() - start;
+    free(threads);
+    pthread_mutex_destroy(&batch.resultsLock);
+    bool complete = batch.results.games == settings.numGames;
+    if (!complete) {
+        fprintf(stderr, "Only %lld of %lld games were played.\n", batch.results.games, settings.numGames);
     }
     
-    else if (numWhite > numBlack) {
-        return 'W';
+    //A position file missing some games would hold empty records for them, so it is not kept
+    if (settings.positionFile != NULL) {
+        if (!closePositionFile(settings.positionFile)) {
+            fprintf(stderr, "Could not write position file %s.\n", positionFileName);
+            complete = false;
+        }
+        if (!complete) {
+            unlink(positionFileName);
+        }
     }
+    closeOpeningBook(&settings.book);
     
-    else {
-        return 'B';
+    //Print the results
+    const SelfPlayResults *results = &batch.results;
+    long long games = results->games > 0 ? results->games : 1;
+    char blackName[32], whiteName[32];
+    formatEngine(&settings.engines[colourIndex('B')], blackName, sizeof(blackName));
+    formatEngine(&settings.engines[colourIndex('W')], whiteName, sizeof(whiteName));
+    printf("Games: %lld (%dx%d, B %s, W %s, %d opening moves, seed %llu)\n", results->games,
+           settings.dimension, settings.dimension, blackName, whiteName, settings.openingMoves,
+           (unsigned long long) settings.seed);
+    printf("B wins: %lld (%.1f%%)\n", results->wins[colourIndex('B')], 100.0 * results->wins[colourIndex('B')] / games);
+    printf("W wins: %lld (%.1f%%)\n", results->wins[colourIndex('W')], 100.0 * results->wins[colourIndex('W')] / games);
+    printf("Draws: %lld (%.1f%%)\n", results->draws, 100.0 * results->draws / games);
+    printf("Average disc margin (B - W): %.2f\n", (double) results->discMargin / games);
+    printf("Average game length: %.2f moves, %.2f passes\n", (double) results->moves / games,
+           (double) results->passes / games);
+    printf("Time: %.3f s\n", seconds);
+    printf("Games per second: %.0f\n", seconds > 0 ? results->games / seconds : 0.0);
+    return complete ? 0 : 1;
+}
+
+//Reads the command line options into the computer settings, returns false if an option is not recognised
+bool parseOptions(int argc, char **argv, ComputerSettings *settings) {
+    for (int i = 1; i < argc; i++) {
+        
+        //Options without a value
+        if (strcmp(argv[i], "--verbose") == 0) {
+            settings->verbose = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--wld") == 0) {
+            settings->endgameWinLossDraw = true;
+            continue;
+        }
+        if (strcmp(argv[i], "--ponder") == 0) {
+            settings->ponder = true;
+            continue;
+        }
+        
+        //Every other option takes a value
+        if (i + 1 >= argc) {
+            return false;
+        }
+        
+        if (strcmp(argv[i], "--depth") == 0) {
+            settings->searchDepth = atoi(argv[++i]);
+            if (settings->searchDepth < 0 || settings->searchDepth > MAX_SEARCH_DEPTH) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--nodes") == 0) {
+            settings->searchNodes = atoll(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--threads") == 0) {
+            settings->threads = atoi(argv[++i]);
+            if (settings->threads < 1) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--book") == 0) {
+            settings->bookFileName = argv[++i];
+        }
+        else if (strcmp(argv[i], "--endgame") == 0) {
+            settings->endgameEmpties = atoi(argv[++i]);
+            if (settings->endgameEmpties < 0) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--hash") == 0) {
+            settings->hashMegabytes = atoi(argv[++i]);
+            if (settings->hashMegabytes < 0) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--mcts") == 0) {
+            settings->mctsPlayouts = atoll(argv[++i]);
+            if (settings->mctsPlayouts < 0) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--mcts-time") == 0) {
+            settings->mctsMilliseconds = atoi(argv[++i]);
+            if (settings->mctsMilliseconds < 0) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--exploration") == 0) {
+            settings->mctsExploration = atof(argv[++i]);
+            if (settings->mctsExploration < 0) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--movetime") == 0) {
+            settings->moveMilliseconds = atoi(argv[++i]);
+            if (settings->moveMilliseconds < 0) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--time-control") == 0) {
+            char *end = NULL;
+            settings->clockSeconds = strtod(argv[++i], &end);
+            if (*end == '+') {
+                settings->incrementSeconds = strtod(end + 1, &end);
+            }
+            if (*end != '\0' || settings->clockSeconds <= 0 || settings->incrementSeconds < 0) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--tree") == 0) {
+            settings->treeMegabytes = atoi(argv[++i]);
+            if (settings->treeMegabytes < 1) {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--render") == 0) {
+            i++;
+            if (strcmp(argv[i], "full") == 0) {
+                settings->renderMode = RENDER_FULL;
+            }
+            else if (strcmp(argv[i], "diff") == 0) {
+                settings->renderMode = RENDER_DIFF;
+            }
+            else if (strcmp(argv[i], "silent") == 0) {
+                settings->renderMode = RENDER_SILENT;
+            }
+            else {
+                return false;
+            }
+        }
+        else if (strcmp(argv[i], "--stats") == 0) {
+            i++;
+            if (strcmp(argv[i], "json") == 0) {
+                settings->statsMode = STATS_GAME;
+            }
+            else if (strcmp(argv[i], "json-moves") == 0) {
+                settings->statsMode = STATS_MOVES;
+            }
+            else {
+                return false;
+            }
+#ifndef OTHELLO_STATS
+            fprintf(stderr, "Statistics are only counted when built with -DOTHELLO_STATS.\n");
+            return false;
+#endif
+        }
+        else {
+            return false;
+        }
     }
+    return true;
 }
 
+//Programs built on these functions, such as the benchmarks, define OTHELLO_LIBRARY to leave out the game
+#ifndef OTHELLO_LIBRARY
 int main(int argc, char **argv)
 {
 	//Declare variables
@@ -668,13 +5003,87 @@ int main(int argc, char **argv)
     bool printNeeded = true;
     bool gameOver = false;
     char winner = 0;
+    GameState game;
+    MoveTracker tracker;
+    BoardRenderer renderer = {0};
+    
+    //Run perft instead of a game if asked
+    if (argc > 1 && strcmp(argv[1], "perft") == 0) {
+        return runPerft(argc, argv);
+    }
+    
+    //Build an opening book instead of a game if asked
+    if (argc > 1 && strcmp(argv[1], "book") == 0) {
+        return runBook(argc, argv);
+    }
+    
+    //Solve the positions in a position file instead of a game if asked
+    if (argc > 1 && strcmp(argv[1], "solve") == 0) {
+        return runSolve(argc, argv);
+    }
+    
+    //Run a batch of self-play games instead of a game if asked
+    if (argc > 1 && strcmp(argv[1], "selfplay") == 0) {
+        return runSelfPlay(argc, argv);
+    }
+    
+    //Read the settings for the computer
+    if (!parseOptions(argc, argv, &computerSettings)) {
+        printUsage(argv[0]);
+        return 1;
+    }
+    renderer.mode = computerSettings.renderMode;
+    
+    //Set up the hash table if the computer searches, which it does whenever it plays against the clock
+    initZobristKeys();
+    computerClock = computerSettings.clockSeconds;
+    bool searches = computerSettings.searchDepth > 0 || computerSettings.moveMilliseconds > 0 ||
+                    computerSettings.clockSeconds > 0;
+    if (searches && computerSettings.hashMegabytes > 0) {
+        if (!createHashTable(&hashTable, computerSettings.hashMegabytes)) {
+            fprintf(stderr, "Could not allocate a %d MB hash table.\n", computerSettings.hashMegabytes);
+            return 1;
+        }
+    }
+    
+    //Set up the arena for the search tree if the computer uses Monte Carlo tree search
+    if (computerSettings.mctsPlayouts > 0 || computerSettings.mctsMilliseconds > 0) {
+        if (!createMctsArena(&mctsArena, computerSettings.treeMegabytes)) {
+            fprintf(stderr, "Could not allocate a %d MB search tree.\n", computerSettings.treeMegabytes);
+            return 1;
+        }
+    }
+    
+    //Open the opening book if the computer has one
+    if (computerSettings.bookFileName != NULL && !openOpeningBook(computerSettings.bookFileName, &openingBook)) {
+        fprintf(stderr, "Could not open opening book %s.\n", computerSettings.bookFileName);
+        return 1;
+    }
     
-    //Get the dimensions of the board
+#ifdef OTHELLO_STATS
+    Stats gameStats;
+    double gameStart = getSeconds();
+    double gameCpu = 0;
+    snapshotStats(&gameStats, &gameCpu);
+#endif
+    
+    //Get the dimensions of the board, every table the board functions use stops at the largest dimension
     printf("Enter the board dimension: ");
-    scanf("%d", &boardDimension);
+    if (scanf("%d", &boardDimension) != 1 || boardDimension < 2 || boardDimension > MAX_DIMENSION) {
+        fprintf(stderr, "The board dimension must be from 2 to %d.\n", MAX_DIMENSION);
+        return 1;
+    }
+    
+    //A book for another dimension has none of this game's positions
+    if (openingBook.entries != NULL && openingBook.dimension != boardDimension) {
+        fprintf(stderr, "Opening book is for %dx%d boards, not using it.\n", openingBook.dimension, openingBook.dimension);
+        closeOpeningBook(&openingBook);
+    }
     
-    //Set up the board
-    setupBoard(board, boardDimension);
+    //Set up the game on its bit board, copy it to the board that is printed, and start tracking the valid moves
+    setupGameState(boardDimension, turn, &game);
+    storeBitBoard(&game.board, board);
+    startMoveTracker(&game, &tracker);
     
     //Get colour of computer player
     printf("Computer plays (B/W): ");
@@ -693,12 +5102,12 @@ int main(int argc, char **argv)
         
         //Print out board if necessary
         if (printNeeded) {
-            printBoard(board, boardDimension);
+            renderBoard(&renderer, board, boardDimension);
             printNeeded = false;
         }
         
         //Ensure the game is not over as a result of previous move (no available moves or board is full)
-        if (isGameOver(board, boardDimension, player, computer)) {
+        if (isGameOver(&game, &tracker)) {
             gameOver = true;
             break;
         }
@@ -706,12 +5115,18 @@ int main(int argc, char **argv)
         //If it is the player's turn, attempt to make player move
         if (turn == player) {
             
-            //Check to see that the player has an available move
-            int numValidPositions = countValidPositions(board, boardDimension, player);
-            
             //If there is an available move, prompt user to make one
-            if (numValidPositions > 0) {
-                bool validMove = makeMove(board, boardDimension, player);
+            if (tracker.numValid[colourIndex(player)] > 0) {
+                
+                //Search on the human's time while waiting for the move, if the computer searches
+                bool pondering = computerSettings.ponder && hashTable.slots != NULL && startPonder(&ponder, &game);
+                bool validMove = makeMove(board, boardDimension, player, &game, &tracker);
+                if (pondering) {
+                    stopPonder(&ponder);
+                    if (computerSettings.verbose && validMove) {
+                        reportPonder(&ponder, &game.undoStack[game.undoDepth - 1].move);
+                    }
+                }
             
                 //If player made invalid move, end the game, declare computer as winner
                 if (!validMove) {
@@ -730,6 +5145,7 @@ int main(int argc, char **argv)
             //If there is no available move for the player, switch turn to computer
             else {
                 printf("%c player has no valid move.\n", player);
+                passGameState(&game);
                 turn = computer;
             }
             
@@ -738,12 +5154,9 @@ int main(int argc, char **argv)
         //If it is the computer's turn, attempt to make computer move
         else {
             
-            //Check to see that the computer has an available move
-            int numValidPositions = countValidPositions(board, boardDimension, computer);
-            
             //If there is an available move, make it
-            if (numValidPositions > 0) {
-                makeComputerMove(board, boardDimension, computer);
+            if (tracker.numValid[colourIndex(computer)] > 0) {
+                makeComputerMove(board, boardDimension, computer, &game, &tracker);
                 
                 //Switch turn to player and ensure board is printed
                 turn = player;
@@ -753,6 +5166,7 @@ int main(int argc, char **argv)
             //If there is no available move for the computer, switch turn to player
             else {
                 printf("%c player has no valid move.\n", computer);
+                passGameState(&game);
                 turn = player;
             }
             
@@ -760,13 +5174,14 @@ int main(int argc, char **argv)
     }
     
     //At this point, the game is over
+    finishRendering(&renderer);
     
     /**Determine if player has yet to be determined
      * If so, determine the winner
      * The winner will only have been determined already at this point by an invalid player move during gameplay
      */
     if (winner == 0) {
-        winner = determineWinner(board, boardDimension);
+        winner = determineBitBoardWinner(&game.board);
     }
     
     //Output result if not a draw
@@ -779,5 +5194,22 @@ int main(int argc, char **argv)
         printf("Draw!");
     }
     
+    if (computerSettings.verbose && hashTable.slots != NULL) {
+        printHashTableStats(&hashTable);
+    }
+    if (computerSettings.verbose && mctsArena.nodes != NULL) {
+        fprintf(stderr, "MCTS peak tree memory: %.1f MB of %d MB\n", mctsArena.peak * sizeof(MctsNode) / (1024.0 * 1024.0),
+                computerSettings.treeMegabytes);
+    }
+#ifdef OTHELLO_STATS
+    if (computerSettings.statsMode != STATS_OFF) {
+        Stats endStats;
+        double endCpu = 0;
+        snapshotStats(&endStats, &endCpu);
+        printStatsJson("game", 0, &gameStats, &endStats, getSeconds() - gameStart, endCpu - gameCpu);
+    }
+#endif
+    
 	return 0;
 }
+#endif
@@ -0,0 +1,458 @@
+//Needed for pinning the benchmark to one CPU
+#define _GNU_SOURCE
+#include <sched.h>
+
+#define OTHELLO_LIBRARY
+#include "othello.c"
+
+#define DEFAULT_BENCH_POSITIONS 64
+#define DEFAULT_BENCH_WARMUP 2
+#define DEFAULT_BENCH_SAMPLES 10
+#define BENCH_SAMPLE_SECONDS 0.01 //Each sample repeats its pass over the positions until it has been timed for this long
+
+//A position reached by random play, with the colour to move
+typedef struct {
+    char board[26][26];
+    char turn;
+} BenchPosition;
+
+//The positions every kernel is timed over for one board dimension
+typedef struct {
+    int dimension;
+    int numPositions;
+    BenchPosition *positions;
+    GameState *states; //The same positions as game states, for the kernels that take them
+    MoveTracker *trackers;
+} BenchCorpus;
+
+//A kernel runs once over the whole corpus, adding the seconds it was timed for and returning the operations it made
+typedef long long (*BenchKernel)(const BenchCorpus *corpus, double *seconds);
+
+//Keeps the kernels' results alive so the compiler cannot leave the calls out
+volatile long long benchSink;
+
+//Game state and tracker for the kernels that change the position, restored from the corpus before each operation
+GameState benchState;
+MoveTracker benchTracker;
+
+/**Builds a corpus of positions reached by random play from the start, stopping after a random number of moves
+ * Each position is seeded from the seed, the dimension and its index, so runs with the same seed time the same positions
+ * A colour with no valid move passes, and games that end before their stopping point keep their final position
+ */
+bool buildBenchCorpus(BenchCorpus *corpus, int dimension, int numPositions, uint64_t seed) {
+    corpus->dimension = dimension;
+    corpus->numPositions = numPositions;
+    corpus->positions = malloc(numPositions * sizeof(BenchPosition));
+    corpus->states = malloc(numPositions * sizeof(GameState));
+    corpus->trackers = malloc(numPositions * sizeof(MoveTracker));
+    if (corpus->positions == NULL || corpus->states == NULL || corpus->trackers == NULL) {
+        return false;
+    }
+    
+    for (int i = 0; i < numPositions; i++) {
+        BenchPosition *position = &corpus->positions[i];
+        GameState *state = &corpus->states[i];
+        uint64_t random = seed ^ ((uint64_t) dimension << 32) ^ (uint64_t) i;
+        int numMoves = nextRandom(&random) % (dimension * dimension - 3);
+        MoveList moves;
+        bool passed = false;
+        
+        setupBoard(position->board, dimension);
+        loadGameState(position->board, dimension, 'B', state);
+        for (int move = 0; move < numMoves; move++) {
+            generateBitBoardMoves(&state->board, state->turn, &moves);
+            if (moves.numMoves == 0) {
+                if (passed) {
+                    break;
+                }
+                passGameState(state);
+                passed = true;
+                move--;
+                continue;
+            }
+            passed = false;
+            
+            const Move *chosen = &moves.moves[nextRandom(&random) % moves.numMoves];
+            applyMove(position->board, chosen, state->turn);
+            makeGameStateMove(state, chosen);
+        }
+        
+        //Leave the colour to move with a move where there is one
+        generateBitBoardMoves(&state->board, state->turn, &moves);
+        if (moves.numMoves == 0) {
+            passGameState(state);
+            generateBitBoardMoves(&state->board, state->turn, &moves);
+            if (moves.numMoves == 0) {
+                passGameState(state);
+            }
+        }
+        position->turn = state->turn;
+        loadGameState(position->board, dimension, position->turn, state);
+        startMoveTracker(state, &corpus->trackers[i]);
+    }
+    return true;
+}
+
+void freeBenchCorpus(BenchCorpus *corpus) {
+    free(corpus->positions);
+    free(corpus->states);
+    free(corpus->trackers);
+}
+
+/**Calls one search direction from every unoccupied position of every corpus position
+ * Each direction has its own kernel below, which the compiler turns into direct calls
+ */
+static inline long long benchSearch(const BenchCorpus *corpus, double *seconds,
+                                    int (*search)(int, int, char, char[][26], int))
+{
+    int dimension = corpus->dimension;
+    long long ops = 0, sum = 0;
+    double start = getSeconds();
+    for (int i = 0; i < corpus->numPositions; i++) {
+        BenchPosition *position = &corpus->positions[i];
+        for (int row = 0; row < dimension; row++) {
+            for (int col = 0; col < dimension; col++) {
+                if (position->board[row][col] == 'U') {
+                    sum += search(row, col, position->turn, position->board, dimension);
+                    ops++;
+                }
+            }
+        }
+    }
+    *seconds += getSeconds() - start;
+    benchSink = sum;
+    return ops;
+}
+
+long long benchSearchNorth(const BenchCorpus *corpus, double *seconds) {
+    return benchSearch(corpus, seconds, searchNorth);
+}
+
+long long benchSearchNorthEast(const BenchCorpus *corpus, double *seconds) {
+    return benchSearch(corpus, seconds, searchNorthEast);
+}
+
+long long benchSearchEast(const BenchCorpus *corpus, double *seconds) {
+    return benchSearch(corpus, seconds, searchEast);
+}
+
+long long benchSearchSouthEast(const BenchCorpus *corpus, double *seconds) {
+    return benchSearch(corpus, seconds, searchSouthEast);
+}
+
+long long benchSearchSouth(const BenchCorpus *corpus, double *seconds) {
+    return benchSearch(corpus, seconds, searchSouth);
+}
+
+long long benchSearchSouthWest(const BenchCorpus *corpus, double *seconds) {
+    return benchSearch(corpus, seconds, searchSouthWest);
+}
+
+long long benchSearchWest(const BenchCorpus *corpus, double *seconds) {
+    return benchSearch(corpus, seconds, searchWest);
+}
+
+long long benchSearchNorthWest(const BenchCorpus *corpus, double *seconds) {
+    return benchSearch(corpus, seconds, searchNorthWest);
+}
+
+//Checks every unoccupied position of every corpus position
+long long benchCheckValidPosition(const BenchCorpus *corpus, double *seconds) {
+    int dimension = corpus->dimension;
+    long long ops = 0, sum = 0;
+    double start = getSeconds();
+    for (int i = 0; i < corpus->numPositions; i++) {
+        BenchPosition *position = &corpus->positions[i];
+        for (int row = 0; row < dimension; row++) {
+            for (int col = 0; col < dimension; col++) {
+                if (position->board[row][col] == 'U') {
+                    sum += checkValidPosition(row, col, position->turn, position->board, dimension);
+                    ops++;
+                }
+            }
+        }
+    }
+    *seconds += getSeconds() - start;
+    benchSink = sum;
+    return ops;
+}
+
+//Scores every unoccupied position of every corpus position
+long long benchEvaluatePosition(const BenchCorpus *corpus, double *seconds) {
+    int dimension = corpus->dimension;
+    long long ops = 0, sum = 0;
+    double start = getSeconds();
+    for (int i = 0; i < corpus->numPositions; i++) {
+        BenchPosition *position = &corpus->positions[i];
+        for (int row = 0; row < dimension; row++) {
+            for (int col = 0; col < dimension; col++) {
+                if (position->board[row][col] == 'U') {
+                    sum += evaluatePosition(row, col, position->turn, position->board, dimension);
+                    ops++;
+                }
+            }
+        }
+    }
+    *seconds += getSeconds() - start;
+    benchSink = sum;
+    return ops;
+}
+
+//Counts the valid positions of the colour to move in every corpus position
+long long benchCountValidPositions(const BenchCorpus *corpus, double *seconds) {
+    long long sum = 0;
+    double start = getSeconds();
+    for (int i = 0; i < corpus->numPositions; i++) {
+        BenchPosition *position = &corpus->positions[i];
+        sum += countValidPositions(position->board, corpus->dimension, position->turn);
+    }
+    *seconds += getSeconds() - start;
+    benchSink = sum;
+    return corpus->numPositions;
+}
+
+//Checks whether the game is over in every corpus position
+long long benchIsGameOver(const BenchCorpus *corpus, double *seconds) {
+    long long sum = 0;
+    double start = getSeconds();
+    for (int i = 0; i < corpus->numPositions; i++) {
+        sum += isGameOver(&corpus->states[i], &corpus->trackers[i]);
+    }
+    *seconds += getSeconds() - start;
+    benchSink = sum;
+    return corpus->numPositions;
+}
+
+//Counts the tiles of every corpus position for the winner
+long long benchDetermineBitBoardWinner(const BenchCorpus *corpus, double *seconds) {
+    long long sum = 0;
+    double start = getSeconds();
+    for (int i = 0; i < corpus->numPositions; i++) {
+        sum += determineBitBoardWinner(&corpus->states[i].board);
+    }
+    *seconds += getSeconds() - start;
+    benchSink = sum;
+    return corpus->numPositions;
+}
+
+//Prints every corpus position, to /dev/null while the benchmark runs, flushing so the writes are timed too
+long long benchPrintBoard(const BenchCorpus *corpus, double *seconds) {
+    double start = getSeconds();
+    for (int i = 0; i < corpus->numPositions; i++) {
+        printBoard(corpus->positions[i].board, corpus->dimension);
+    }
+    fflush(stdout);
+    *seconds += getSeconds() - start;
+    return corpus->numPositions;
+}
+
+/**Makes the computer's move in every corpus position with a valid move, with the computer's default settings
+ * The position is restored before each move, which is not timed
+ */
+long long benchMakeComputerMove(const BenchCorpus *corpus, double *seconds) {
+    long long ops = 0;
+    char board[26][26];
+    for (int i = 0; i < corpus->numPositions; i++) {
+        const BenchPosition *position = &corpus->positions[i];
+        if (corpus->trackers[i].numValid[colourIndex(position->turn)] == 0) {
+            continue;
+        }
+        memcpy(board, position->board, sizeof(board));
+        loadGameState(board, corpus->dimension, position->turn, &benchState);
+        startMoveTracker(&benchState, &benchTracker);
+        
+        double start = getSeconds();
+        makeComputerMove(board, corpus->dimension, position->turn, &benchState, &benchTracker);
+        *seconds += getSeconds() - start;
+        ops++;
+    }
+    fflush(stdout);
+    return ops;
+}
+
+//Name of each kernel as it appears in the results
+typedef struct {
+    const char *name;
+    BenchKernel kernel;
+} BenchEntry;
+
+const BenchEntry BENCH_KERNELS[] = {
+    {"searchNorth", benchSearchNorth},
+    {"searchNorthEast", benchSearchNorthEast},
+    {"searchEast", benchSearchEast},
+    {"searchSouthEast", benchSearchSouthEast},
+    {"searchSouth", benchSearchSouth},
+    {"searchSouthWest", benchSearchSouthWest},
+    {"searchWest", benchSearchWest},
+    {"searchNorthWest", benchSearchNorthWest},
+    {"checkValidPosition", benchCheckValidPosition},
+    {"countValidPositions", benchCountValidPositions},
+    {"evaluatePosition", benchEvaluatePosition},
+    {"makeComputerMove", benchMakeComputerMove},
+    {"isGameOver", benchIsGameOver},
+    {"determineBitBoardWinner", benchDetermineBitBoardWinner},
+    {"printBoard", benchPrintBoard}
+};
+
+#define NUM_BENCH_KERNELS ((int) (sizeof(BENCH_KERNELS) / sizeof(BENCH_KERNELS[0])))
+
+//Finds a kernel by name, NULL if there is no kernel with that name
+const BenchEntry *findBenchKernel(const char *name) {
+    for (int i = 0; i < NUM_BENCH_KERNELS; i++) {
+        if (strcmp(name, BENCH_KERNELS[i].name) == 0) {
+            return &BENCH_KERNELS[i];
+        }
+    }
+    return NULL;
+}
+
+//Runs a kernel over the corpus until it has been timed for a whole sample, returning the time per operation
+double sampleBenchKernel(const BenchEntry *entry, const BenchCorpus *corpus, long long *ops) {
+    double seconds = 0;
+    long long sampleOps = 0;
+    do {
+        sampleOps += entry->kernel(corpus, &seconds);
+    } while (seconds < BENCH_SAMPLE_SECONDS && sampleOps > 0);
+    *ops += sampleOps;
+    return sampleOps > 0 ? seconds * 1e9 / sampleOps : 0;
+}
+
+/**Times one kernel on one corpus, writing its result as one line of JSON
+ * The warmup samples come first and are not counted, then the time per operation of each sample gives the mean,
+ * variance and range
+ */
+void runBenchKernel(FILE *out, const BenchEntry *entry, const BenchCorpus *corpus, int warmup, int samples) {
+    double *nanoseconds = malloc(samples * sizeof(double));
+    long long ops = 0;
+    for (int i = 0; i < warmup; i++) {
+        sampleBenchKernel(entry, corpus, &ops);
+    }
+    ops = 0;
+    for (int i = 0; i < samples; i++) {
+        nanoseconds[i] = sampleBenchKernel(entry, corpus, &ops);
+    }
+    
+    double mean = 0, variance = 0, min = INFINITY, max = 0;
+    for (int i = 0; i < samples; i++) {
+        mean += nanoseconds[i];
+        min = nanoseconds[i] < min ? nanoseconds[i] : min;
+        max = nanoseconds[i] > max ? nanoseconds[i] : max;
+    }
+    mean /= samples;
+    for (int i = 0; i < samples; i++) {
+        variance += (nanoseconds[i] - mean) * (nanoseconds[i] - mean);
+    }
+    variance = samples > 1 ? variance / (samples - 1) : 0;
+    
+    fprintf(out, "{\"kernel\":\"%s\",\"dimension\":%d,\"ops\":%lld,\"ns_per_op\":%.3f,\"variance\":%.3f,"
+            "\"stddev\":%.3f,\"min\":%.3f,\"max\":%.3f}\n", entry->name, corpus->dimension, ops, mean, variance,
+            sqrt(variance), min, max);
+    fflush(out);
+    free(nanoseconds);
+}
+
+void printBenchUsage(const char *program) {
+    fprintf(stderr, "Usage: %s [--dimension N] [--positions P] [--warmup W] [--samples S] [--seed S] [--cpu C]\n",
+            program);
+    fprintf(stderr, "          [--kernel NAME]\n");
+    fprintf(stderr, "  --dimension N  only time N by N boards (default every even dimension from 4 to 26)\n");
+    fprintf(stderr, "  --positions P  random positions timed for each dimension (default %d)\n", DEFAULT_BENCH_POSITIONS);
+    fprintf(stderr, "  --warmup W     samples run before the timed ones and not counted (default %d)\n",
+            DEFAULT_BENCH_WARMUP);
+    fprintf(stderr, "  --samples S    timed samples, each at least 10 ms of passes over the positions (default %d)\n", DEFAULT_BENCH_SAMPLES);
+    fprintf(stderr, "  --seed S       seed for the random positions (default 1)\n");
+    fprintf(stderr, "  --cpu C        CPU to run on (default the one the benchmark starts on, -1 to not pin)\n");
+    fprintf(stderr, "  --kernel NAME  only time the named kernel, one of:\n");
+    for (int i = 0; i < NUM_BENCH_KERNELS; i++) {
+        fprintf(stderr, "                   %s\n", BENCH_KERNELS[i].name);
+    }
+}
+
+/**Times each kernel in isolation over seeded random positions, writing one line of JSON per kernel and dimension
+ * The first line gives the settings, so runs can be compared
+ */
+int main(int argc, char **argv) {
+    int firstDimension = 4, lastDimension = MAX_DIMENSION;
+    int numPositions = DEFAULT_BENCH_POSITIONS, warmup = DEFAULT_BENCH_WARMUP, samples = DEFAULT_BENCH_SAMPLES;
+    uint64_t seed = 1;
+    int cpu = sched_getcpu();
+    const char *kernelName = NULL;
+    
+    for (int i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            printBenchUsage(argv[0]);
+            return 1;
+        }
+        if (strcmp(argv[i], "--dimension") == 0) {
+            firstDimension = lastDimension = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--positions") == 0) {
+            numPositions = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--warmup") == 0) {
+            warmup = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--samples") == 0) {
+            samples = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--seed") == 0) {
+            seed = strtoull(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--cpu") == 0) {
+            cpu = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--kernel") == 0) {
+            kernelName = argv[++i];
+        }
+        else {
+            printBenchUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (firstDimension < 4 || lastDimension > MAX_DIMENSION || numPositions < 1 || warmup < 0 || samples < 1 ||
+        (kernelName != NULL && findBenchKernel(kernelName) == NULL))
+    {
+        printBenchUsage(argv[0]);
+        return 1;
+    }
+    
+    //Keep the benchmark on one CPU so it is not moved between caches mid-sample
+    if (cpu >= 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(cpu, &cpus);
+        if (sched_setaffinity(0, sizeof(cpus), &cpus) != 0) {
+            fprintf(stderr, "Could not pin the benchmark to CPU %d.\n", cpu);
+            return 1;
+        }
+    }
+    
+    //Results go to the real stdout, the boards and moves the kernels print go to /dev/null
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    if (out == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "Could not redirect the kernels' output.\n");
+        return 1;
+    }
+    
+    initZobristKeys();
+    fprintf(out, "{\"benchmark\":\"othello\",\"seed\":%llu,\"positions\":%d,\"warmup\":%d,\"samples\":%d,\"cpu\":%d}\n",
+            (unsigned long long) seed, numPositions, warmup, samples, cpu);
+    
+    //Othello is played on even dimensions, so a range only covers those
+    for (int dimension = firstDimension; dimension <= lastDimension; dimension += firstDimension == lastDimension ? 1 : 2) {
+        BenchCorpus corpus;
+        if (!buildBenchCorpus(&corpus, dimension, numPositions, seed)) {
+            fprintf(stderr, "Could not allocate %d positions.\n", numPositions);
+            return 1;
+        }
+        for (int i = 0; i < NUM_BENCH_KERNELS; i++) {
+            if (kernelName == NULL || strcmp(kernelName, BENCH_KERNELS[i].name) == 0) {
+                runBenchKernel(out, &BENCH_KERNELS[i], &corpus, warmup, samples);
+            }
+        }
+        freeBenchCorpus(&corpus);
+    }
+    
+    fclose(out);
+    return 0;
+}
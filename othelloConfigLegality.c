@@ -1,5 +1,31 @@
 #include <stdio.h>
 #include <stdbool.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+//Number of directions a ray can travel from a position
+#define NUM_DIRECTIONS 8
+
+//Valid move along with how many tiles it flips in each direction, North first and continuing clockwise
+typedef struct {
+    short row;
+    short col;
+    short totalFlips;
+    unsigned char numFlips[NUM_DIRECTIONS];
+} Move;
+
+//Every valid move for a colour, in the same order as the board
+typedef struct {
+    int numMoves;
+    Move moves[26 * 26];
+} MoveList;
 
 //Sets up the board based on dimensions given by user
 void setupBoard(char board[][26], int boardDimension) {
@@ -51,7 +77,7 @@ void printBoard(char board[][26], int boardDimension) {
 
 //Checks to see if entered position is within bounds of board
 bool positionInBounds(int boardDimension, int row, int col) {
-    if (row < boardDimension && col < boardDimension) {
+    if (row >= 0 && row < boardDimension && col >= 0 && col < boardDimension) {
         return true;
     }
     return false;
@@ -77,307 +103,197 @@ void getBoardConfig(char board [][26], int boardDimension) {
     }
 }
 
-/**Checks if row and col is a legal position for a tile
- * "Looks" in direction specified, receives how many positions in each direction to look
- * A move has a chance to be legal if the spot being looked at is the opposite colour
+//Change in row and column for one step in each direction, North first and continuing clockwise
+const int DELTA_ROW[NUM_DIRECTIONS] = {-1, -1, 0, 1, 1, 1, 0, -1};
+const int DELTA_COL[NUM_DIRECTIONS] = {0, 1, 1, 1, 0, -1, -1, -1};
+
+//Distance between positions one row apart on a board, which always has 26 columns whatever its dimension
+#define BOARD_ROW_STRIDE 26
+
+//Step through a board for one position in each direction
+const int RAY_STEP[NUM_DIRECTIONS] = {
+    -BOARD_ROW_STRIDE, -BOARD_ROW_STRIDE + 1, 1, BOARD_ROW_STRIDE + 1, BOARD_ROW_STRIDE, BOARD_ROW_STRIDE - 1, -1,
+    -BOARD_ROW_STRIDE - 1
+};
+
+//Number of positions between each position and the edge of the board in each direction, for one dimension
+typedef unsigned char RayLengths[26][26][NUM_DIRECTIONS];
+
+/**Ray lengths for each dimension, built the first time a board of that dimension is searched, on whichever thread
+ * gets there first, so only the dimensions in use take up memory
+ * The flag lets every later search skip the lock
  */
-bool checkLegalInDirection(char board[][26], int boardDimension, int row, int col, char colour, int deltaRow, int deltaCol) {
-    
-    //Determine the position function should check
-    int testRow = row + deltaRow;
-    int testCol = col + deltaCol;
-    
-    //Ensure position is in bounds, if out of bounds return false
-    if (!positionInBounds(boardDimension, testRow, testCol)) {
-        return false;
-    }
-    
-    //Determine the opposite colour
-    char oppositeColour = '0';
-    if (colour == 'W') {
-        oppositeColour = 'B';
-    }
-    else {
-        oppositeColour = 'W';
-    }
-    
-    //Check position to see if it is occupied by the opposite colour
-    //If so, this direction has a chance to be a legal move (it is legal so far)
-    if (board[testRow][testCol] == oppositeColour) {
-        return true;
-    }
-    //If position is unoccupied or the same colour, move is no longer legal
-    else {
-        return false;
+RayLengths rayLengths[26 + 1];
+atomic_bool rayLengthsBuilt[26 + 1];
+pthread_mutex_t rayLengthsLock = PTHREAD_MUTEX_INITIALIZER;
+
+void buildRayLengths(int boardDimension) {
+    for (int row = 0; row < boardDimension; row++) {
+        for (int col = 0; col < boardDimension; col++) {
+            for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+                
+                //Step out until the next step would leave the board
+                int length = 0;
+                int testRow = row + DELTA_ROW[direction];
+                int testCol = col + DELTA_COL[direction];
+                while (positionInBounds(boardDimension, testRow, testCol)) {
+                    length++;
+                    testRow += DELTA_ROW[direction];
+                    testCol += DELTA_COL[direction];
+                }
+                rayLengths[boardDimension][row][col][direction] = length;
+            }
+        }
     }
 }
 
-/**Checks to see if the final position of a travelled direction qualifies position as a valid move
- * Compares colour at this position to player's colour
- */
-bool checkFinalPosition (int row, int col, char colour, int boardDimension, char board[][26]) {
-    if (positionInBounds(boardDimension, row, col) && board[row][col] == colour) {
-        return true;
+//Gets the ray lengths for a board dimension, building them if no search has needed them yet
+const RayLengths *getRayLengths(int boardDimension) {
+    if (!atomic_load_explicit(&rayLengthsBuilt[boardDimension], memory_order_acquire)) {
+        pthread_mutex_lock(&rayLengthsLock);
+        if (!atomic_load_explicit(&rayLengthsBuilt[boardDimension], memory_order_relaxed)) {
+            buildRayLengths(boardDimension);
+            atomic_store_explicit(&rayLengthsBuilt[boardDimension], true, memory_order_release);
+        }
+        pthread_mutex_unlock(&rayLengthsLock);
     }
-    return false;
+    return &rayLengths[boardDimension];
 }
 
-//Searches in the North Direction, returns how many tiles can be flipped, zero if no move can be made
-int searchNorth(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in North position
-    int deltaNorth = -1;
+/**Walks a ray out from a position, returns how many tiles can be flipped, zero if no move can be made
+ * The ray's length stops the walk at the edge of the board, so no step has to be checked against the bounds
+ */
+int walkRay(const char *start, int length, int step, char colour, char opponent) {
     
-    //Track how many tiles can be flipped
+    //Count the opposite colour tiles next to the position, only stepping while the ray has positions left
     int tilesFlipped = 0;
-    
-    //Check in North direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot North, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaNorth, 0)) {
-        deltaNorth--;
+    const char *square = start;
+    while (tilesFlipped < length && *(square += step) == opponent) {
         tilesFlipped++;
     }
     
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaNorth, col, colour, boardDimension, board)) {
+    //They are only flipped if the ray carries on to one of the colour's tiles, the position the walk stopped at
+    if (tilesFlipped > 0 && tilesFlipped < length && *square == colour) {
         return tilesFlipped;
     }
-    else {
-        return 0;
-    }
+    return 0;
+}
+
+//Walks the ray from a position in the direction given
+int searchRay(char board[][26], int boardDimension, int row, int col, char colour, int direction) {
+    const char *start = (const char *) board + row * BOARD_ROW_STRIDE + col;
+    int length = (*getRayLengths(boardDimension))[row][col][direction];
+    return walkRay(start, length, RAY_STEP[direction], colour, colour == 'W' ? 'B' : 'W');
+}
+
+//Searches in the North Direction, returns how many tiles can be flipped, zero if no move can be made
+int searchNorth(int row, int col, char colour, char board[][26], int boardDimension) {
+    return searchRay(board, boardDimension, row, col, colour, 0);
 }
 
 //Searches in the North East Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchNorthEast(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in North East position
-    int deltaNorth = -1;
-    int deltaEast = 1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in North East direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot North East, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaNorth, deltaEast)) {
-        deltaNorth--;
-        deltaEast++;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaNorth, col + deltaEast, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, 1);
 }
 
 //Searches in the East Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchEast(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in East position
-    int deltaEast = 1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in East direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot East, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, 0, deltaEast)) {
-        deltaEast++;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row, col + deltaEast, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, 2);
 }
 
 //Searches in the South East Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchSouthEast(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in South East position
-    int deltaSouth = 1;
-    int deltaEast = 1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in South East direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot South East, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaSouth, deltaEast)) {
-        deltaSouth++;
-        deltaEast++;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaSouth, col + deltaEast, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, 3);
 }
 
 //Searches in the South Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchSouth(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in South position
-    int deltaSouth = 1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in South direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot South, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaSouth, 0)) {
-        deltaSouth++;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaSouth, col, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, 4);
 }
 
 //Searches in the South West Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchSouthWest(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in South West position
-    int deltaSouth = 1;
-    int deltaWest = -1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in South West direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot South West, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaSouth, deltaWest)) {
-        deltaSouth++;
-        deltaWest--;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaSouth, col + deltaWest, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, 5);
 }
 
 //Searches in the West Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchWest(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in West position
-    int deltaWest = -1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in West direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot West, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, 0, deltaWest)) {
-        deltaWest--;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row, col + deltaWest, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, 6);
 }
 
 //Searches in the North West Direction, returns how many tiles can be flipped, zero if no move can be made
 int searchNorthWest(int row, int col, char colour, char board[][26], int boardDimension) {
-    
-    //Initialize change in North West position
-    int deltaNorth = -1;
-    int deltaWest = -1;
-    
-    //Track how many tiles can be flipped
-    int tilesFlipped = 0;
-    
-    //Check in North West direction for opposite colour (meaning direction has a chance to be legal)
-    //If opposite colour is found, move one more spot North West, and add to tiles flipped
-    while (checkLegalInDirection(board, boardDimension, row, col, colour, deltaNorth, deltaWest)) {
-        deltaNorth--;
-        deltaWest--;
-        tilesFlipped++;
-    }
-    
-    //If opposite colours were found, check the final position to see if move is valid
-    if (tilesFlipped > 0 && checkFinalPosition(row + deltaNorth, col + deltaWest, colour, boardDimension, board)) {
-        return tilesFlipped;
-    }
-    else {
-        return 0;
-    }
+    return searchRay(board, boardDimension, row, col, colour, 7);
 }
 
 //Checks to see if a specified position is valid for a move
 bool checkValidPosition(int row, int col, char colour, char board[][26], int boardDimension) {
     
     //If there is a move to be made in any of the 8 directions, return true
-    //This is represented by the search in that direction being greater than zero
-    
-    if (searchNorth(row, col, colour, board, boardDimension) > 0) {
-        return true;
-    }
-    else if (searchNorthEast(row, col, colour, board, boardDimension) > 0) {
-        return true;
-    }
-    else if (searchEast(row, col, colour, board, boardDimension) > 0) {
-        return true;
-    }
-    else if (searchSouthEast(row, col, colour, board, boardDimension) > 0) {
-        return true;
-    }
-    else if (searchSouth(row, col, colour, board, boardDimension) > 0) {
-        return true;
-    }
-    else if (searchSouthWest(row, col, colour, board, boardDimension) > 0) {
-        return true;
-    }
-    else if (searchWest(row, col, colour, board, boardDimension) > 0) {
-        return true;
-    }
-    else if (searchNorthWest(row, col, colour, board, boardDimension) > 0) {
-        return true;
+    //This is represented by the walk along the ray in that direction finding tiles to flip
+    const unsigned char *lengths = (*getRayLengths(boardDimension))[row][col];
+    const char *start = (const char *) board + row * BOARD_ROW_STRIDE + col;
+    char opponent = colour == 'W' ? 'B' : 'W';
+    for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+        if (walkRay(start, lengths[direction], RAY_STEP[direction], colour, opponent) > 0) {
+            return true;
+        }
     }
     return false;
 }
 
-//Finds valid positions and prints them out
-void findValidPositions(char board[][26], int boardDimension, char colour) {
+//Generates every valid move for a colour, searching each direction only once per position
+void generateMoves(char board[][26], int boardDimension, char colour, MoveList *moveList) {
+    const RayLengths *lengths = getRayLengths(boardDimension);
+    char opponent = colour == 'W' ? 'B' : 'W';
+    moveList->numMoves = 0;
     
     //Iterate through all positions on board
     for (int row = 0; row < boardDimension; row++) {
         for (int col = 0; col < boardDimension; col++) {
             
-            //Ensure position is unoccupied and position is valid
-            if (board[row][col] == 'U' && checkValidPosition(row, col, colour, board, boardDimension)) {
-                printf("%c%c\n", row + 'a', col + 'a');
+            //Ensure position is unoccupied
+            if (board[row][col] != 'U') {
+                continue;
+            }
+            
+            //Count how many tiles would be flipped in each direction
+            Move *move = &moveList->moves[moveList->numMoves];
+            move->row = row;
+            move->col = col;
+            const char *start = (const char *) board + row * BOARD_ROW_STRIDE + col;
+            move->totalFlips = 0;
+            for (int direction = 0; direction < NUM_DIRECTIONS; direction++) {
+                move->numFlips[direction] = walkRay(start, (*lengths)[row][col][direction], RAY_STEP[direction], colour,
+                                                    opponent);
+                move->totalFlips += move->numFlips[direction];
+            }
+            
+            //Position is valid if any tiles can be flipped
+            if (move->totalFlips > 0) {
+                moveList->numMoves++;
             }
         }
     }
 }
 
+//Finds the move at a position in a list of moves, returns NULL if the position is not a valid move
+const Move *findMove(const MoveList *moveList, int row, int col) {
+    for (int i = 0; i < moveList->numMoves; i++) {
+        if (moveList->moves[i].row == row && moveList->moves[i].col == col) {
+            return &moveList->moves[i];
+        }
+    }
+    return NULL;
+}
+
+//Prints out the valid positions in a list of moves
+void findValidPositions(const MoveList *moveList) {
+    for (int i = 0; i < moveList->numMoves; i++) {
+        printf("%c%c\n", moveList->moves[i].row + 'a', moveList->moves[i].col + 'a');
+    }
+}
+
 //Flips tiles in the North direction
 void flipNorth(char board[][26], int row, int col, int numFlips, char colour) {
     
@@ -451,8 +367,45 @@ void flipNorthWest(char board[][26], int row, int col, int numFlips, char colour
     }
 }
 
-//Attempts to make move specified by user
-bool makeMove(char board[][26], int boardDimension) {
+//Makes a move from a list of moves on the board
+void applyMove(char board[][26], const Move *move, char colour) {
+    int row = move->row;
+    int col = move->col;
+    
+    //Make the flips that can be made
+    if (move->numFlips[0] > 0) {
+        flipNorth(board, row, col, move->numFlips[0], colour);
+    }
+    if (move->numFlips[1] > 0) {
+        flipNorthEast(board, row, col, move->numFlips[1], colour);
+    }
+    if (move->numFlips[2] > 0) {
+        flipEast(board, row, col, move->numFlips[2], colour);
+    }
+    if (move->numFlips[3] > 0) {
+        flipSouthEast(board, row, col, move->numFlips[3], colour);
+    }
+    if (move->numFlips[4] > 0) {
+        flipSouth(board, row, col, move->numFlips[4], colour);
+    }
+    if (move->numFlips[5] > 0) {
+        flipSouthWest(board, row, col, move->numFlips[5], colour);
+    }
+    if (move->numFlips[6] > 0) {
+        flipWest(board, row, col, move->numFlips[6], colour);
+    }
+    if (move->numFlips[7] > 0) {
+        flipNorthWest(board, row, col, move->numFlips[7], colour);
+    }
+    
+    //Place chip at chosen position
+    board[row][col] = colour;
+}
+
+/**Attempts to make move specified by user
+ * Moves for White and Black come from the lists already generated, any other colour gets its own list
+ */
+bool makeMove(char board[][26], int boardDimension, const MoveList *whiteMoves, const MoveList *blackMoves) {
     
     //Get move from player
     char colour = '0', rowChar = '0', colChar = '0';
@@ -463,68 +416,693 @@ bool makeMove(char board[][26], int boardDimension) {
     int row = rowChar - 'a';
     int col = colChar - 'a';
     
-    //Ensure space is unoccupied
-    if (board[row][col] != 'U') {
+    //Choose the list of valid moves for the colour
+    MoveList otherMoves;
+    const MoveList *colourMoves = &otherMoves;
+    if (colour == 'W') {
+        colourMoves = whiteMoves;
+    }
+    else if (colour == 'B') {
+        colourMoves = blackMoves;
+    }
+    else {
+        generateMoves(board, boardDimension, colour, &otherMoves);
+    }
+    
+    //If position is not in the list of valid moves, move is invalid
+    const Move *move = findMove(colourMoves, row, col);
+    if (move == NULL) {
         return false;
     }
     
-    //Count how many tiles need to be fliiped in each direction
-    int numFlipNorth = searchNorth(row, col, colour, board, boardDimension);
-    int numFlipNorthEast = searchNorthEast(row, col, colour, board, boardDimension);
-    int numFlipEast = searchEast(row, col, colour, board, boardDimension);
-    int numFlipSouthEast = searchSouthEast(row, col, colour, board, boardDimension);
-    int numFlipSouth = searchSouth(row, col, colour, board, boardDimension);
-    int numFlipSouthWest = searchSouthWest(row, col, colour, board, boardDimension);
-    int numFlipWest = searchWest(row, col, colour, board, boardDimension);
-    int numFlipNorthWest = searchNorthWest(row, col, colour, board, boardDimension);
-    
-    //If all of these values are 0 (sum is 0), no flips can be made, and move is invalid
-    if (numFlipNorth + numFlipNorthEast + numFlipEast + numFlipSouthEast + 
-        numFlipSouth + numFlipSouthWest + numFlipWest + numFlipNorthWest == 0) 
-    {
+    //Make the flips and place player's chip at chosen position
+    applyMove(board, move, colour);
+    
+    return true;
+}
+
+//Identifies a binary position file, stored in the first bytes of its header
+#define POSITION_FILE_MAGIC "OTHPOS1"
+
+//Marks a position record that has no move to check
+#define NO_POSITION_MOVE 0xFF
+
+/**Header at the start of a binary position file, followed by numPositions records of recordSize bytes
+ * Each record holds the colour to move (or of the move to check), then the move's row and col (NO_POSITION_MOVE if
+ * there is none, the dimension if it is off the board), then five zero bytes, then one bit per position for Black
+ * and then for White, bit (row * dimension + col) in 64-bit words of host byte order
+ */
+typedef struct {
+    char magic[8];
+    uint32_t dimension;
+    uint32_t recordSize;
+    uint64_t numPositions;
+} PositionFileHeader;
+
+//Binary position file mapped into memory, either read-only or being written
+typedef struct {
+    int fd;
+    bool writable;
+    unsigned char *data;
+    size_t mappedSize;
+    int dimension;
+    int numWords; //Words in each colour's set of positions
+    size_t recordSize;
+    uint64_t numPositions;
+    uint64_t capacity; //Records the mapping has room for while writing
+} PositionFile;
+
+//Number of 64-bit words holding one bit per position on a board
+int countPositionWords(int boardDimension) {
+    return (boardDimension * boardDimension + 63) / 64;
+}
+
+//Maps a binary position file for reading, returns false if it cannot be opened or is not a valid position file
+bool openPositionFile(const char *fileName, PositionFile *file) {
+    memset(file, 0, sizeof(PositionFile));
+    file->fd = open(fileName, O_RDONLY);
+    if (file->fd < 0) {
         return false;
     }
     
-    //At this point, moves can be made
+    struct stat status;
+    PositionFileHeader header;
+    if (fstat(file->fd, &status) != 0 || (size_t)status.st_size < sizeof(header)) {
+        close(file->fd);
+        return false;
+    }
+    file->mappedSize = status.st_size;
+    file->data = mmap(NULL, file->mappedSize, PROT_READ, MAP_PRIVATE, file->fd, 0);
+    if (file->data == MAP_FAILED) {
+        close(file->fd);
+        return false;
+    }
     
-    //Make the moves that can be made
-    if (numFlipNorth > 0) {
-        flipNorth(board, row, col, numFlipNorth, colour);
+    //Check the header describes records that fit in the file
+    memcpy(&header, file->data, sizeof(header));
+    bool valid = memcmp(header.magic, POSITION_FILE_MAGIC, sizeof(header.magic)) == 0
+                 && header.dimension >= 4 && header.dimension <= 26;
+    if (valid) {
+        file->dimension = header.dimension;
+        file->numWords = countPositionWords(file->dimension);
+        file->recordSize = header.recordSize;
+        file->numPositions = header.numPositions;
+        valid = file->recordSize == 8 + 2 * 8 * (size_t)file->numWords
+                && file->numPositions <= (file->mappedSize - sizeof(header)) / file->recordSize;
+    }
+    if (!valid) {
+        munmap(file->data, file->mappedSize);
+        close(file->fd);
+        return false;
     }
-    if (numFlipNorthEast > 0) {
-        flipNorthEast(board, row, col, numFlipNorthEast, colour);
+    return true;
+}
+
+//Resizes a position file being written and maps it again with room for the given number of records
+bool reservePositions(PositionFile *file, uint64_t capacity) {
+    size_t size = sizeof(PositionFileHeader) + capacity * file->recordSize;
+    if (file->data != NULL) {
+        munmap(file->data, file->mappedSize);
+        file->data = NULL;
+    }
+    if (ftruncate(file->fd, size) != 0) {
+        return false;
     }
-    if (numFlipEast > 0) {
-        flipEast(board, row, col, numFlipEast, colour);
+    file->data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, file->fd, 0);
+    if (file->data == MAP_FAILED) {
+        file->data = NULL;
+        return false;
     }
-    if (numFlipSouthEast > 0) {
-        flipSouthEast(board, row, col, numFlipSouthEast, colour);
+    file->mappedSize = size;
+    file->capacity = capacity;
+    return true;
+}
+
+//Creates a binary position file for boards of one dimension and maps it for writing
+bool createPositionFile(const char *fileName, int boardDimension, uint64_t capacity, PositionFile *file) {
+    memset(file, 0, sizeof(PositionFile));
+    
+    //Position files hold the same dimensions as othello accepts for them
+    if (boardDimension < 4 || boardDimension > 26) {
+        fprintf(stderr, "Position files must have a dimension from 4 to 26\n");
+        return false;
     }
-    if (numFlipSouth > 0) {
-        flipSouth(board, row, col, numFlipSouth, colour);
+    file->fd = open(fileName, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (file->fd < 0) {
+        return false;
     }
-    if (numFlipSouthWest > 0) {
-        flipSouthWest(board, row, col, numFlipSouthWest, colour);
+    file->writable = true;
+    file->dimension = boardDimension;
+    file->numWords = countPositionWords(boardDimension);
+    file->recordSize = 8 + 2 * 8 * file->numWords;
+    if (!reservePositions(file, capacity > 0 ? capacity : 1)) {
+        close(file->fd);
+        unlink(fileName);
+        return false;
     }
-    if (numFlipWest > 0) {
-        flipWest(board, row, col, numFlipWest, colour);
+    return true;
+}
+
+//Gets the bytes of a record in a mapped position file
+unsigned char *getPositionRecord(const PositionFile *file, uint64_t index) {
+    return file->data + sizeof(PositionFileHeader) + index * file->recordSize;
+}
+
+//Gets room for the next record at the end of a position file being written, growing the file if it is full
+unsigned char *appendPositionRecord(PositionFile *file) {
+    if (file->numPositions == file->capacity && !reservePositions(file, 2 * file->capacity)) {
+        return NULL;
     }
-    if (numFlipNorthWest > 0) {
-        flipNorthWest(board, row, col, numFlipNorthWest, colour);
+    return getPositionRecord(file, file->numPositions++);
+}
+
+/**Finishes with a position file, writing the header and trimming unused records from a file being written
+ * Returns false if a file being written could not be completed
+ */
+bool closePositionFile(PositionFile *file) {
+    bool success = true;
+    if (file->writable && file->data != NULL) {
+        PositionFileHeader header = {POSITION_FILE_MAGIC, file->dimension, file->recordSize, file->numPositions};
+        memcpy(file->data, &header, sizeof(header));
+        success = msync(file->data, file->mappedSize, MS_SYNC) == 0;
+    }
+    if (file->data != NULL) {
+        munmap(file->data, file->mappedSize);
+    }
+    if (file->writable) {
+        success = success && file->data != NULL
+                  && ftruncate(file->fd, sizeof(PositionFileHeader) + file->numPositions * file->recordSize) == 0;
+    }
+    file->data = NULL;
+    return close(file->fd) == 0 && success;
+}
+
+/**Packs a board and its move into a position record, row and col are ignored if there is no move
+ * Positions that are neither W nor B are stored as unoccupied
+ */
+void encodePosition(unsigned char *record, const PositionFile *file, char board[][26], char colour, bool hasMove,
+                    int row, int col)
+{
+    uint64_t black[26 * 26 / 64 + 1] = {0}, white[26 * 26 / 64 + 1] = {0};
+    for (int i = 0; i < file->dimension; i++) {
+        for (int j = 0; j < file->dimension; j++) {
+            int bit = i * file->dimension + j;
+            if (board[i][j] == 'B') {
+                black[bit / 64] |= 1ULL << (bit % 64);
+            }
+            else if (board[i][j] == 'W') {
+                white[bit / 64] |= 1ULL << (bit % 64);
+            }
+        }
     }
     
-    //Place player's chip at chosen position
-    board[row][col] = colour;
+    //A move off the board is kept as one that can never be valid, only a missing move is stored as none
+    memset(record, 0, 8);
+    record[0] = colour;
+    record[1] = !hasMove ? NO_POSITION_MOVE : positionInBounds(file->dimension, row, col) ? row : file->dimension;
+    record[2] = !hasMove ? NO_POSITION_MOVE : positionInBounds(file->dimension, row, col) ? col : file->dimension;
+    memcpy(record + 8, black, 8 * file->numWords);
+    memcpy(record + 8 + 8 * file->numWords, white, 8 * file->numWords);
+}
+
+//Unpacks a position record into a board, its colour and its move's row and col (-1 if none)
+void decodePosition(const unsigned char *record, const PositionFile *file, char board[][26], char *colour, int *row, int *col) {
+    uint64_t black[26 * 26 / 64 + 1], white[26 * 26 / 64 + 1];
+    memcpy(black, record + 8, 8 * file->numWords);
+    memcpy(white, record + 8 + 8 * file->numWords, 8 * file->numWords);
+    
+    for (int i = 0; i < file->dimension; i++) {
+        for (int j = 0; j < file->dimension; j++) {
+            int bit = i * file->dimension + j;
+            if (black[bit / 64] >> (bit % 64) & 1) {
+                board[i][j] = 'B';
+            }
+            else if (white[bit / 64] >> (bit % 64) & 1) {
+                board[i][j] = 'W';
+            }
+            else {
+                board[i][j] = 'U';
+            }
+        }
+    }
+    
+    *colour = record[0];
+    *row = record[1] == NO_POSITION_MOVE ? -1 : record[1];
+    *col = record[2] == NO_POSITION_MOVE ? -1 : record[2];
+}
+
+//Bytes requested from the input on each read in batch mode
+#define READ_CHUNK (1 << 20)
+
+//Positions parsed and handed to the worker threads at a time in batch mode
+#define BATCH_BLOCK 1024
+
+//Largest output of one position: both move lists, their headers and the verdict
+#define POSITION_OUTPUT_SIZE (2 * 26 * 26 * 3 + 64)
+
+//Most worker threads batch mode will start
+#define MAX_BATCH_THREADS 64
+
+//Input read in large chunks and parsed straight out of memory
+typedef struct {
+    FILE *file;
+    char *buffer;
+    size_t length;
+    size_t position;
+} BufferedReader;
+
+//One configuration from a batch, along with the text it produces
+typedef struct {
+    int boardDimension;
+    char board[26][26];
+    bool hasMove; //Positions read from a position file might not have a move to check
+    char moveColour;
+    int moveRow;
+    int moveCol;
+    int outputLength;
+    char output[POSITION_OUTPUT_SIZE];
+} BatchPosition;
+
+//Where batch mode reads its positions from
+typedef struct {
+    BufferedReader *reader; //Text configurations, or NULL to read from a position file
+    const PositionFile *positionFile;
+    uint64_t nextPosition;
+    bool failed; //Set when a configuration could not be read, rather than the input ending
+} BatchInput;
+
+//Share of a block of positions processed by one worker thread
+typedef struct {
+    BatchPosition *positions;
+    int numPositions;
+    int first;
+    int step;
+} BatchWorker;
+
+//Moves any unread bytes to the front of the buffer and reads the next chunk behind them, false at end of input
+bool fillReader(BufferedReader *reader) {
+    size_t remaining = reader->length - reader->position;
+    memmove(reader->buffer, reader->buffer + reader->position, remaining);
+    reader->length = remaining;
+    reader->position = 0;
+    
+    size_t bytesRead = fread(reader->buffer + remaining, 1, READ_CHUNK, reader->file);
+    reader->length += bytesRead;
+    return bytesRead > 0;
+}
+
+//Returns the next byte of input without consuming it, or EOF
+int peekReader(BufferedReader *reader) {
+    if (reader->position == reader->length && !fillReader(reader)) {
+        return EOF;
+    }
+    return (unsigned char)reader->buffer[reader->position];
+}
+
+//Consumes and returns the next byte of input, or EOF
+int nextReader(BufferedReader *reader) {
+    int c = peekReader(reader);
+    if (c != EOF) {
+        reader->position++;
+    }
+    return c;
+}
+
+//Skips spaces, tabs and newlines the same way scanf does
+void skipWhitespace(BufferedReader *reader) {
+    int c = peekReader(reader);
+    while (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\v' || c == '\f') {
+        reader->position++;
+        c = peekReader(reader);
+    }
+}
+
+//Reads a decimal integer like scanf("%d"), false if there is none
+bool readInteger(BufferedReader *reader, int *value) {
+    skipWhitespace(reader);
+    
+    int sign = 1;
+    int c = peekReader(reader);
+    if (c == '-' || c == '+') {
+        sign = c == '-' ? -1 : 1;
+        reader->position++;
+        c = peekReader(reader);
+    }
+    if (c < '0' || c > '9') {
+        return false;
+    }
     
+    int number = 0;
+    while (c >= '0' && c <= '9') {
+        number = number * 10 + (c - '0');
+        reader->position++;
+        c = peekReader(reader);
+    }
+    *value = sign * number;
     return true;
 }
 
+//Reads three characters after any whitespace like scanf(" %c%c%c"), false at end of input
+bool readTriple(BufferedReader *reader, char *first, char *second, char *third) {
+    skipWhitespace(reader);
+    int a = nextReader(reader);
+    int b = nextReader(reader);
+    int c = nextReader(reader);
+    if (c == EOF) {
+        return false;
+    }
+    *first = (char)a;
+    *second = (char)b;
+    *third = (char)c;
+    return true;
+}
+
+/**Parses one configuration: the dimension, coloured positions up to the line containing '!', then the move
+ * Returns false with the reason printed if the configuration cannot be read
+ */
+bool readBatchPosition(BufferedReader *reader, BatchPosition *position) {
+    const char END_CHAR = '!';
+    
+    if (!readInteger(reader, &position->boardDimension)) {
+        fprintf(stderr, "Expected a board dimension\n");
+        return false;
+    }
+    if (position->boardDimension < 2 || position->boardDimension > 26) {
+        fprintf(stderr, "Invalid board dimension %d\n", position->boardDimension);
+        return false;
+    }
+    setupBoard(position->board, position->boardDimension);
+    
+    //Place coloured positions until the end of the configuration
+    char colour = '0', row = '0', col = '0';
+    while (colour != END_CHAR && row != END_CHAR && col != END_CHAR) {
+        if (!readTriple(reader, &colour, &row, &col)) {
+            fprintf(stderr, "Configuration ends before its move\n");
+            return false;
+        }
+        if (positionInBounds(position->boardDimension, row - 'a', col - 'a')) {
+            position->board[row - 'a'][col - 'a'] = colour;
+        }
+    }
+    
+    if (!readTriple(reader, &position->moveColour, &row, &col)) {
+        fprintf(stderr, "Configuration ends before its move\n");
+        return false;
+    }
+    position->hasMove = true;
+    position->moveRow = row - 'a';
+    position->moveCol = col - 'a';
+    return true;
+}
+
+//Reads the next position from either text or a position file, false when there are no more or one cannot be read
+bool readBatchInput(BatchInput *input, BatchPosition *position) {
+    if (input->reader != NULL) {
+        
+        //Only running out of input between configurations is the end of the batch, anything else is an error
+        skipWhitespace(input->reader);
+        if (peekReader(input->reader) == EOF) {
+            return false;
+        }
+        if (!readBatchPosition(input->reader, position)) {
+            input->failed = true;
+            return false;
+        }
+        return true;
+    }
+    if (input->nextPosition == input->positionFile->numPositions) {
+        return false;
+    }
+    
+    const unsigned char *record = getPositionRecord(input->positionFile, input->nextPosition++);
+    position->boardDimension = input->positionFile->dimension;
+    decodePosition(record, input->positionFile, position->board, &position->moveColour, &position->moveRow,
+                   &position->moveCol);
+    position->hasMove = position->moveRow >= 0;
+    return true;
+}
+
+//Appends a string to a position's output
+void appendOutput(BatchPosition *position, const char *text) {
+    int length = (int)strlen(text);
+    memcpy(position->output + position->outputLength, text, length);
+    position->outputLength += length;
+}
+
+//Appends each move in the list to a position's output, one per line
+void appendMoves(BatchPosition *position, const MoveList *moveList) {
+    char *output = position->output + position->outputLength;
+    for (int i = 0; i < moveList->numMoves; i++) {
+        *output++ = moveList->moves[i].row + 'a';
+        *output++ = moveList->moves[i].col + 'a';
+        *output++ = '\n';
+    }
+    position->outputLength += moveList->numMoves * 3;
+}
+
+//Finds both colours' moves and the verdict on the move for one position, writing them to its output
+void processBatchPosition(BatchPosition *position) {
+    MoveList whiteMoves, blackMoves, otherMoves;
+    generateMoves(position->board, position->boardDimension, 'W', &whiteMoves);
+    generateMoves(position->board, position->boardDimension, 'B', &blackMoves);
+    
+    position->outputLength = 0;
+    appendOutput(position, "Available moves for W:\n");
+    appendMoves(position, &whiteMoves);
+    appendOutput(position, "Available moves for B:\n");
+    appendMoves(position, &blackMoves);
+    
+    if (!position->hasMove) {
+        return;
+    }
+    
+    //Choose the list of valid moves for the colour of the move
+    const MoveList *colourMoves = &otherMoves;
+    if (position->moveColour == 'W') {
+        colourMoves = &whiteMoves;
+    }
+    else if (position->moveColour == 'B') {
+        colourMoves = &blackMoves;
+    }
+    else {
+        generateMoves(position->board, position->boardDimension, position->moveColour, &otherMoves);
+    }
+    
+    if (findMove(colourMoves, position->moveRow, position->moveCol) != NULL) {
+        appendOutput(position, "Valid move.\n");
+    }
+    else {
+        appendOutput(position, "Invalid move.\n");
+    }
+}
+
+//Processes every step-th position of a block starting from first
+void *runBatchWorker(void *argument) {
+    BatchWorker *worker = argument;
+    for (int i = worker->first; i < worker->numPositions; i += worker->step) {
+        processBatchPosition(&worker->positions[i]);
+    }
+    return NULL;
+}
+
+/**Checks every configuration in the input, spreading each block of positions across the worker threads
+ * Output for a block is gathered in input order and written with a single call
+ */
+int runBatch(BatchInput *input, int numThreads) {
+    BatchPosition *positions = malloc(BATCH_BLOCK * sizeof(BatchPosition));
+    char *output = malloc((size_t)BATCH_BLOCK * POSITION_OUTPUT_SIZE);
+    if (positions == NULL || output == NULL) {
+        fprintf(stderr, "Could not allocate batch buffers\n");
+        free(output);
+        free(positions);
+        return 1;
+    }
+    
+    pthread_t threads[MAX_BATCH_THREADS];
+    bool started[MAX_BATCH_THREADS];
+    BatchWorker workers[MAX_BATCH_THREADS];
+    bool finished = false;
+    
+    while (!finished) {
+        
+        //Parse the next block of positions
+        int numPositions = 0;
+        while (numPositions < BATCH_BLOCK) {
+            if (!readBatchInput(input, &positions[numPositions])) {
+                finished = true;
+                break;
+            }
+            numPositions++;
+        }
+        
+        //Split the block between the calling thread and the helpers
+        int numWorkers = numThreads < numPositions ? numThreads : numPositions;
+        for (int t = 0; t < numWorkers; t++) {
+            workers[t] = (BatchWorker){positions, numPositions, t, numWorkers};
+        }
+        for (int t = 1; t < numWorkers; t++) {
+            started[t] = pthread_create(&threads[t], NULL, runBatchWorker, &workers[t]) == 0;
+        }
+        if (numWorkers > 0) {
+            runBatchWorker(&workers[0]);
+        }
+        
+        //A helper that could not be started has its share checked on the calling thread
+        for (int t = 1; t < numWorkers; t++) {
+            if (started[t]) {
+                pthread_join(threads[t], NULL);
+            }
+            else {
+                runBatchWorker(&workers[t]);
+            }
+        }
+        
+        //Gather the block's output in input order
+        size_t outputLength = 0;
+        for (int i = 0; i < numPositions; i++) {
+            memcpy(output + outputLength, positions[i].output, positions[i].outputLength);
+            outputLength += positions[i].outputLength;
+        }
+        fwrite(output, 1, outputLength, stdout);
+    }
+    
+    fflush(stdout);
+    free(output);
+    free(positions);
+    return input->failed ? 1 : 0;
+}
+
+/**Writes the configurations from a batch to a position file instead of checking them
+ * Every configuration in a position file must have the same dimension
+ */
+int writeBatchPositions(BatchInput *input, const char *fileName) {
+    BatchPosition *position = malloc(sizeof(BatchPosition));
+    PositionFile file;
+    bool created = false, success = position != NULL;
+    
+    while (success && readBatchInput(input, position)) {
+        if (!created) {
+            success = created = createPositionFile(fileName, position->boardDimension, BATCH_BLOCK, &file);
+        }
+        else if (position->boardDimension != file.dimension) {
+            fprintf(stderr, "Every position in a position file must have dimension %d\n", file.dimension);
+            success = false;
+        }
+        
+        unsigned char *record = success ? appendPositionRecord(&file) : NULL;
+        if (record != NULL) {
+            encodePosition(record, &file, position->board, position->moveColour, position->hasMove, position->moveRow,
+                           position->moveCol);
+        }
+        success = success && record != NULL;
+    }
+    if (input->failed) {
+        success = false;
+    }
+    
+    if (created && !closePositionFile(&file)) {
+        success = false;
+    }
+    
+    //Do not leave a truncated file behind that looks like a complete one
+    if (created && !success) {
+        unlink(fileName);
+    }
+    if (!success || !created) {
+        fprintf(stderr, "Could not write positions to %s\n", fileName);
+    }
+    else {
+        fprintf(stderr, "Wrote %llu positions to %s\n", (unsigned long long)file.numPositions, fileName);
+    }
+    free(position);
+    return success && created ? 0 : 1;
+}
+
+//Prints how to run the program
+void printUsage(const char *program) {
+    fprintf(stderr, "Usage: %s\n", program);
+    fprintf(stderr, "       %s --batch [file] [--threads N] [--write-positions out.pos]\n", program);
+}
+
+/**Runs batch mode: "--batch [file] [--threads N] [--write-positions out.pos]"
+ * The file holds text configurations, or is a position file; without one, text is read from standard input
+ */
+int runBatchMode(int argc, char **argv) {
+    const char *fileName = NULL, *outputName = NULL;
+    int numThreads = 1;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            numThreads = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--write-positions") == 0 && i + 1 < argc) {
+            outputName = argv[++i];
+        }
+        else if (argv[i][0] != '-' || strcmp(argv[i], "-") == 0) {
+            fileName = argv[i];
+        }
+        else {
+            printUsage(argv[0]);
+            return 1;
+        }
+    }
+    if (numThreads < 1 || numThreads > MAX_BATCH_THREADS) {
+        fprintf(stderr, "Threads must be between 1 and %d\n", MAX_BATCH_THREADS);
+        return 1;
+    }
+    
+    //Map a position file directly, otherwise read text in chunks
+    PositionFile positionFile;
+    BufferedReader reader = {stdin, NULL, 0, 0};
+    BatchInput input = {NULL, &positionFile, 0, false};
+    bool mapped = fileName != NULL && strcmp(fileName, "-") != 0 && openPositionFile(fileName, &positionFile);
+    if (!mapped) {
+        if (fileName != NULL && strcmp(fileName, "-") != 0) {
+            reader.file = fopen(fileName, "rb");
+            if (reader.file == NULL) {
+                perror(fileName);
+                return 1;
+            }
+        }
+        reader.buffer = malloc(2 * READ_CHUNK);
+        if (reader.buffer == NULL) {
+            fprintf(stderr, "Could not allocate batch buffers\n");
+            return 1;
+        }
+        input.reader = &reader;
+    }
+    
+    int result = 0;
+    if (outputName != NULL) {
+        result = writeBatchPositions(&input, outputName);
+    }
+    else {
+        result = runBatch(&input, numThreads);
+    }
+    
+    if (mapped) {
+        closePositionFile(&positionFile);
+    }
+    else {
+        if (reader.file != stdin) {
+            fclose(reader.file);
+        }
+        free(reader.buffer);
+    }
+    return result;
+}
+
 int main(int argc, char **argv)
 {
+    //Check many configurations at once when asked for batch mode
+    if (argc > 1 && strcmp(argv[1], "--batch") == 0) {
+        return runBatchMode(argc, argv);
+    }
+    
     //Declare variables
     int boardDimension = 0;
     char board[26][26] = {{0}};
     bool validMove = false;
+    MoveList whiteMoves, blackMoves;
     
 	//Get the dimensions of the board
     printf("Enter the board dimension: ");
@@ -543,16 +1121,20 @@ int main(int argc, char **argv)
     //Print out board
     printBoard(board, boardDimension);
     
+    //Find the valid moves for both colours once
+    generateMoves(board, boardDimension, 'W', &whiteMoves);
+    generateMoves(board, boardDimension, 'B', &blackMoves);
+    
     //Print out available moves for White
     printf("Available moves for W:\n");
-    findValidPositions(board, boardDimension, 'W');
+    findValidPositions(&whiteMoves);
     
     //Print out available moves for Black
     printf("Available moves for B:\n");
-    findValidPositions(board, boardDimension, 'B');
+    findValidPositions(&blackMoves);
     
     //Get move from user, attempt to make it
-    validMove = makeMove(board, boardDimension);
+    validMove = makeMove(board, boardDimension, &whiteMoves, &blackMoves);
     
     //Output if move is valid
     if (validMove) {